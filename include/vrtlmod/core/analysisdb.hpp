@@ -0,0 +1,106 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file analysisdb.hpp
+/// @brief On-disk layout of the binary analysis database (*-vrtlmod.db)
+/// @details The database holds the elaboration and analysis results of a VRTL, i.e., everything build_xml writes
+/// to the analysis XML, so that later runs can skip both parse runs (--reuse-analysis). All fields are 32 bit words
+/// in host byte order, records are 4 byte aligned and read in place from the memory-mapped file:
+///
+///     Header
+///     uint32_t string offsets[string_count + 1]   (into string data)
+///     char     string data[]                      (padded to 4 bytes)
+///     Cell     top cell                           (if has_top_cell)
+///     module_count times:
+///         Module
+///         uint32_t instances[instance_count]      (string ids)
+///         Cell     cells[cell_count]
+///         variable_count times:
+///             Variable
+///             Location inj_locs[inj_loc_count]
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_CORE_ANALYSISDB_HPP__
+#define __VRTLMOD_CORE_ANALYSISDB_HPP__
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for all core vrtlmod functionalities
+namespace vrtlmod
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for the records of the binary analysis database
+namespace analysisdb
+{
+
+constexpr char MAGIC[8] = { 'V', 'R', 'T', 'L', 'M', 'O', 'D', 'B' };
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint32_t NONE = UINT32_MAX; ///< string id of absent strings, e.g., file of a not declared node
+
+struct Header
+{
+    char magic_[8];           ///< MAGIC
+    uint32_t format_version_; ///< FORMAT_VERSION
+    uint32_t version_;        ///< string id of the writing vrtlmod version
+    uint32_t string_count_;   ///< number of strings in the string table
+    uint32_t string_size_;    ///< size of the string data in bytes, without padding
+    uint32_t has_top_cell_;   ///< 1 if a top cell record follows the string table
+    uint32_t module_count_;   ///< number of module records
+};
+
+struct Location
+{
+    uint32_t file_; ///< string id of the file path, NONE if no location
+    uint32_t line_;
+    uint32_t column_;
+};
+
+struct Cell
+{
+    uint32_t id_;
+    uint32_t type_;
+    Location decl_loc_;
+};
+
+struct Module
+{
+    uint32_t id_;
+    Location decl_loc_;
+    uint32_t instance_count_;
+    uint32_t cell_count_;
+    uint32_t variable_count_;
+};
+
+struct Variable
+{
+    uint32_t type_; ///< in, out, inout, var
+    uint32_t id_;
+    uint32_t bases_;
+    uint32_t dim_;
+    uint32_t cxx_type_;
+    int32_t bits_;
+    Location decl_loc_;
+    uint32_t inj_loc_count_;
+};
+
+} // namespace analysisdb
+
+} // namespace vrtlmod
+
+#endif // __VRTLMOD_CORE_ANALYSISDB_HPP__
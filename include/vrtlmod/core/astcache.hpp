@@ -0,0 +1,74 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file astcache.hpp
+/// @brief Serialized ASTs shared between parse runs of different passes
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_CORE_ASTCACHE_HPP__
+#define __VRTLMOD_CORE_ASTCACHE_HPP__
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+namespace clang
+{
+class ASTUnit;
+class PCHContainerOperations;
+} // namespace clang
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for all core vrtlmod functionalities
+namespace vrtlmod
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @class ASTCache
+/// @brief Stores ASTs of parsed VRTL files as *.ast files so that later passes deserialize instead of re-parsing them
+/// @details A cached AST is only valid as long as none of the files it was parsed from changes. Loading a stale AST
+/// fails and the caller has to fall back to a regular parse run.
+class ASTCache
+{
+    fs::path dir_;                                           ///< directory of the serialized ASTs
+    std::shared_ptr<clang::PCHContainerOperations> pch_ops_; ///< container reader, outlives all loaded ASTs
+
+  public:
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns path of the serialized AST of a given source file, i.e., `<filename>-<hash of path>.ast`
+    fs::path get_ast_path(const std::string &file) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Serializes an AST to the cache
+    /// \return true on success
+    bool store(clang::ASTUnit &ast) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Deserializes the AST of a given source file
+    /// \return nullptr if there is no valid AST for the file
+    std::unique_ptr<clang::ASTUnit> load(const std::string &file) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Constructor
+    /// \param dir Cache directory. Created if not existing
+    ASTCache(const fs::path &dir);
+    ~ASTCache(void);
+};
+
+} // namespace vrtlmod
+
+#endif // __VRTLMOD_CORE_ASTCACHE_HPP__
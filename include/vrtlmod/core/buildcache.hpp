@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file buildcache.hpp
+/// @brief Content-hash keyed cache for incremental vrtlmod runs
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_CORE_BUILDCACHE_HPP__
+#define __VRTLMOD_CORE_BUILDCACHE_HPP__
+
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for all core vrtlmod functionalities
+namespace vrtlmod
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @class BuildCache
+/// @brief Persistent cache in the output directory, keyed by content hashes
+/// @details Holds the stamp of the last complete run and the cleaned (comment and macro cleanup) content of each
+/// file. Entries are keyed by the file content, its compile command, and the vrtlmod version.
+class BuildCache
+{
+    fs::path dir_;                    ///< cache directory
+    mutable std::mutex used_mutex_;   ///< guards used_
+    mutable std::set<fs::path> used_; ///< cache entries restored or stored during this run
+
+    fs::path get_entry_path(const std::string &key) const;
+
+  public:
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns hex string of the SHA1 hash of data
+    static std::string hash(const std::string &data);
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns hex string of the SHA1 hash of a file's content. Empty if file is not readable
+    static std::string hash_file(const fs::path &file);
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns cache key of a file, i.e., the hash of its content, its compile command, and the vrtlmod version
+    std::string get_file_key(const fs::path &file, const std::string &command) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Checks whether the last complete run had the same run key
+    bool is_up_to_date(const std::string &run_key) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Stamps a complete run with its key and removes cache entries not used in this run
+    void set_up_to_date(const std::string &run_key) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Removes the stamp of the last complete run, i.e., before a run starts to overwrite the output
+    void set_outdated(void) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Overwrites file with its cached cleaned content
+    /// \param key File key of the content before cleanup
+    /// \return true if cached content was found
+    bool restore_cleaned(const fs::path &file, const std::string &key) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Caches the cleaned content of file
+    /// \param key File key of the content before cleanup
+    void store_cleaned(const fs::path &file, const std::string &key) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Constructor
+    /// \param dir Cache directory. Created if not existing
+    BuildCache(const fs::path &dir);
+};
+
+} // namespace vrtlmod
+
+#endif // __VRTLMOD_CORE_BUILDCACHE_HPP__
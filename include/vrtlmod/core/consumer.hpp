@@ -45,6 +45,8 @@
 #include <fstream>
 #include <iostream>
 #include <initializer_list>
+#include <set>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief namespace for all core vrtlmod functionalities
@@ -87,7 +89,8 @@ class Consumer : public clang::ASTConsumer
     friend std::string util::logging::toLogString(const T &cons);
 
   public:
-    Consumer(clang::Rewriter &rw, const std::string &file); // sets File context
+    Consumer(clang::Rewriter &rw, const std::string &file, bool scoped = false,
+             std::set<std::string> vrtl_dirs = {}); // sets File context
     virtual ~Consumer(){};
 
     void ownHandler(
@@ -101,6 +104,18 @@ class Consumer : public clang::ASTConsumer
     FileContext fc_;
     clang::ast_matchers::MatchFinder matcher_;
     std::list<std::unique_ptr<Handler>> handlers_;
+    bool scoped_;                     ///< HandleTranslationUnit only traverses the VRTL declarations (get_vrtl_scope)
+    std::set<std::string> vrtl_dirs_; ///< real paths of the VRTL directories, empty for the main file's directory
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the top-level declarations of the VRTL in the given translation unit
+    /// \details Verilated module (and symbol table) classes `V*` and the sequential and evaluation functions
+    ///          (`*_sequent__*`, `*_multiclk__*`, `*_eval*`) declared in one of the VRTL directories. All matchers
+    ///          of the passes only find nodes in these, but would otherwise also traverse all of the Verilator,
+    ///          SystemC, and standard library headers
+    /// \param vrtl_dirs Real paths of the VRTL source and header directories, the main file's directory if empty
+    static std::vector<clang::Decl *> get_vrtl_scope(clang::ASTContext &Context,
+                                                     const std::set<std::string> &vrtl_dirs);
 };
 
 } // namespace vrtlmod
@@ -23,17 +23,17 @@
 #define __VRTLMOD_CORE_CORE_HPP__
 
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <set>
+#include <string>
 #include <boost/filesystem.hpp>
-namespace fs = boost::filesystem;
 
-namespace pugi
-{
-class xml_node;
-class xml_document;
-class xml_tree_walker;
-} // namespace pugi
+#include "vrtlmod/core/ordering.hpp"
+
+namespace fs = boost::filesystem;
 
 namespace clang
 {
@@ -83,31 +83,66 @@ class VrtlmodCore
     friend vapi::VapiGenerator; ///<<<
 
   public:
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Injection location found before its variable was elaborated
+    struct DeferredInjectionLocation
+    {
+        std::string module_id_;
+        std::string variable_id_;
+        std::string file_;
+        int line_;
+        int column_;
+    };
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief (module id, variable id) key of lookup indexes
+    using IdPair = std::pair<std::string, std::string>;
+    struct IdPairHash
+    {
+        size_t operator()(const IdPair &p) const
+        {
+            return std::hash<std::string>()(p.first) ^ (std::hash<std::string>()(p.second) << 1);
+        }
+    };
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Targets ordered by ids, not by address, so that generated code is identical for identical inputs
+    using TargetSet = std::set<std::shared_ptr<types::Target>, types::TargetLess>;
     struct Context
     {
-        std::unique_ptr<types::Cell> top_cell_;                       ///< TOP cell
-        std::set<std::shared_ptr<types::Target>> signals_;            ///< Vector containing all parsed (xml) signals
-        std::set<std::shared_ptr<types::Target>> injectable_targets_; ///< Vector containing all injectable targets
-        std::set<std::shared_ptr<types::Target>>
-            toinj_targets_;               ///< Vector containing all from injection targets (filtered signals)
-        std::set<fs::path> parsed_files_; ///< parsed files
-        std::set<std::unique_ptr<types::Module>> modules_;
+        std::unique_ptr<types::Cell> top_cell_; ///< TOP cell
+        TargetSet signals_;                     ///< Vector containing all parsed (xml) signals
+        TargetSet injectable_targets_;          ///< Vector containing all injectable targets
+        TargetSet toinj_targets_;               ///< Vector containing all from injection targets (filtered signals)
+        std::set<fs::path> parsed_files_;       ///< parsed files
+        std::set<std::unique_ptr<types::Module>, types::IdLess> modules_; ///< modules by id
+        bool defer_inj_locs_{ false }; ///< defer injection locations of unknown variables (fused elaboration/analysis)
+        std::vector<DeferredInjectionLocation> deferred_inj_locs_; ///< deferred injection locations
+
+        std::unordered_map<std::string, types::Module *> module_index_;            ///< modules by module id
+        std::unordered_map<IdPair, types::Variable *, IdPairHash> variable_index_; ///< variables by ids
+        std::unordered_map<IdPair, int, IdPairHash> inj_target_index_;             ///< injection target indexes by ids
+        std::vector<std::shared_ptr<types::Target>> inj_target_registry_;          ///< injection targets by index
 
-        std::unique_ptr<pugi::xml_document> xml_doc_;
-        std::unique_ptr<pugi::xml_node> xml_root_node_;
-        std::unique_ptr<pugi::xml_node> xml_netlist_node_;
-        std::unique_ptr<pugi::xml_node> xml_modules_node_;
-        std::unique_ptr<pugi::xml_node> xml_files_node_;
+        std::recursive_mutex mutex_; ///< guards context members against concurrently parsed translation units
     };
     std::unique_ptr<vapi::VapiGenerator> gen_{};
 
   protected:
     std::unique_ptr<Context> ctx_;
-    fs::path out_dir_path_; ///< Specified path to output directory
-    bool systemc_;          ///< vrtl input is systemc
+    fs::path out_dir_path_;          ///< Specified path to output directory
+    bool systemc_;                   ///< vrtl input is systemc
+    bool td_instances_{ false };     ///< target dictionary entry types are explicitly instantiated in a single source
+    bool scoped_traversal_{ false }; ///< parse runs only traverse VRTL module classes and evaluation functions
+
+    std::set<std::string> vrtl_dirs_{}; ///< real paths of the directories of the run's VRTL sources and headers
 
   public: // public GETTERS and SETTERS
     const Context &get_ctx() const { return *ctx_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Lock the context for exclusive access (passes may run in parallel on multiple translation units)
+    std::unique_lock<std::recursive_mutex> lock_ctx(void) const
+    {
+        return std::unique_lock<std::recursive_mutex>(ctx_->mutex_);
+    }
     std::set<fs::path> get_parsed_files(void) const { return ctx_->parsed_files_; }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Returns output directory
@@ -116,6 +151,30 @@ class VrtlmodCore
     /// \brief Returns true if the API generator was configured for SystemC VRTL
     bool is_systemc(void) const { return (systemc_); }
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns true if the target dictionary entry types are explicitly instantiated (see set_td_instances)
+    bool has_td_instances(void) const { return (td_instances_); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Instantiate the target dictionary entry types once in `<top>_td_instances.cpp` instead of in each
+    ///        instrumented VRTL source. The instrumented headers then include the `extern template` declarations of
+    ///        `<top>_td_instances.hpp`. Set before rewriting the VRTL
+    void set_td_instances(bool td_instances) { td_instances_ = td_instances; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns true if parse runs are limited to the VRTL (see set_scoped_traversal)
+    bool has_scoped_traversal(void) const { return (scoped_traversal_); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Limit the AST traversal of parse runs to the verilated module classes and the sequential evaluation
+    ///        functions of the VRTL, instead of all declarations of the translation unit including the Verilator,
+    ///        SystemC, and standard library headers
+    void set_scoped_traversal(bool scoped_traversal) { scoped_traversal_ = scoped_traversal; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the directories of the VRTL sources and headers (see set_vrtl_files)
+    const std::set<std::string> &get_vrtl_dirs(void) const { return (vrtl_dirs_); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Set the VRTL sources and headers of the run. With scoped traversal, parse runs only traverse
+    ///        declarations from their directories
+    /// \param files file paths of the (prepared) VRTL sources and headers
+    void set_vrtl_files(const std::vector<std::string> &files);
+    ///////////////////////////////////////////////////////////////////////
     /// \brief Get extracted targets
     const types::Cell &get_top_cell(void) const { return *(ctx_->top_cell_); }
     ///////////////////////////////////////////////////////////////////////
@@ -136,6 +195,12 @@ class VrtlmodCore
     ///////////////////////////////////////////////////////////////////////
     /// \brief Return the unique module (type of cell) for a given cell
     const types::Module *get_module_from_cell(const types::Cell &c) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns number of injection targets, i.e., indexes are 0 to count - 1
+    size_t get_injection_target_count(void) const { return ctx_->inj_target_registry_.size(); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns injection target of given index (types::Target::get_index)
+    const types::Target &get_injection_target(int idx) const { return *ctx_->inj_target_registry_[idx]; }
 
   public:
     ///////////////////////////////////////////////////////////////////////
@@ -148,8 +213,9 @@ class VrtlmodCore
     /// \brief Prepare headers according to the API
     /// \param files file paths to files ( will sort out *.h/*.hpp and ignore rest)
     /// \return A new vector of sources file paths (path is generated on call)
+    /// \param jobs Number of headers cleaned in parallel (0: all cores)
     /// \details Copies (or overwrites - corresponding to cmd line options) sources
-    std::vector<std::string> prepare_headers(const std::vector<std::string> &files, bool overwrite);
+    std::vector<std::string> prepare_headers(const std::vector<std::string> &files, bool overwrite, unsigned jobs = 1);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Get the header file name of VRTL top module
     std::string get_vrtltopheader_filename(void) const;
@@ -172,39 +238,76 @@ class VrtlmodCore
     std::string getTDExternalDecl(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Return needed include strings
-    std::string get_include_string() const { return "#include \"targetdictionary.hpp\"\n"; }
+    std::string get_include_string() const;
 
     VrtlmodCore(const char *out_dir_path, bool systemc);
     virtual ~VrtlmodCore(void);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Build VRTLFI XML from analysis and eleboration
+    /// \details Collects the injectable targets (build_injectable_targets) and writes the analysis to
+    /// <out>/<top>-vrtlmod.xml. This is the only place an XML document of the analysis is created
     void build_xml(void);
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns default path of the binary analysis database, i.e., <out>/<top>-vrtlmod.db
+    fs::path get_analysis_db_path(void) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Write elaboration and analysis results to a binary analysis database (see analysisdb.hpp)
+    /// \return true on success
+    bool write_analysis_db(const fs::path &file) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Restore elaboration and analysis results from a binary analysis database instead of parsing the VRTL
+    /// \return true on success, false if the file is not a database of this vrtlmod version
+    bool read_analysis_db(const fs::path &file);
+    ///////////////////////////////////////////////////////////////////////
     /// \brief Build VRTLFI API
-    int build_api(void);
+    /// \param api_shards Number of source shards of the API source, 1 for a single source (see VapiGenerator)
+    /// \param jobs Number of threads generating the API sources, 0 for all cores
+    /// \param compare_table Generate table-driven instead of unrolled compare functions
+    int build_api(unsigned api_shards = 1, unsigned jobs = 1, bool compare_table = false);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Print the TD to std::out
     void print_targetdictionary(void) const;
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Defer injection locations of not (yet) elaborated variables instead of dropping them
+    /// \details Needed if elaboration and analysis share a parse run. Resolve with resolve_deferred_injection_locations
+    void defer_injection_locations(bool defer);
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Add deferred injection locations to their (by now elaborated) variables
+    void resolve_deferred_injection_locations(void);
+    ///////////////////////////////////////////////////////////////////////
     /// \brief Applies the given xml file as a whitelist to injectable targets upodating to-inject internal target list
-    int initialize_injection_targets(std::string file = "");
+    /// \param file Whitelist XML, all injectables if empty
+    /// \param rules_file Target selection rules (see RuleFilter) refining the whitelisted targets, none if empty
+    int initialize_injection_targets(std::string file = "", std::string rules_file = "");
 
   protected: // only friends of VrtlmodCore or itself shall use these methods, bc. they return non-const reference to
     // context members or alter them
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns module of given id, nullptr if not found
+    types::Module *find_module(const std::string &module_id) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns variable of given module and variable id, nullptr if not found
+    types::Variable *find_variable(const std::string &module_id, const std::string &var_id) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns index of the injection target of given module and variable id, -1 if not found
+    int find_injection_target(const std::string &module_id, const std::string &var_id) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Makes all analyzed variables with injection locations injectable targets
+    void build_injectable_targets(void);
     std::vector<std::string> prepare_files(const std::vector<std::string> &files,
                                            const std::vector<std::string> &file_ext_matchers, bool overwrite = false);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Get extracted targets
-    std::set<std::shared_ptr<types::Target>> &get_signals(void) const;
+    TargetSet &get_signals(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Get extracted targets
-    std::set<std::shared_ptr<types::Target>> &get_inj_targets(void) const;
+    TargetSet &get_inj_targets(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Get extracted targets
-    std::set<std::shared_ptr<types::Target>> &get_injectable_targets(void) const;
+    TargetSet &get_injectable_targets(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Get a Target of target list by index
-    /// \param idx Index
+    /// \param idx Index (types::Target::get_index)
     /// \return Reference to Target with index idx
     types::Target &get_target_from_index(int idx) const;
     void add_parsed_file(fs::path fpath) const;
@@ -215,18 +318,12 @@ class VrtlmodCore
     /// \brief add a injection target
     void add_injection_target(std::shared_ptr<types::Target> t) const;
     ///////////////////////////////////////////////////////////////////////
-    /// \brief add a injection target
-    void add_injection_target(const types::Target &t) const;
-    ///////////////////////////////////////////////////////////////////////
     /// \brief apply a passed target filter to injectables
     void apply_target_filter(std::unique_ptr<Filter> filter) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief add a signal
     void add_signal(std::shared_ptr<types::Target> sig) const;
     ///////////////////////////////////////////////////////////////////////
-    /// \brief Get extracted targets
-    void set_top_cell(const pugi::xml_node &node) const;
-    ///////////////////////////////////////////////////////////////////////
     /// \brief register a cell as the top cell from AST, a top cell has no instance in the symboltable
     const types::Cell *set_top_cell(const clang::FieldDecl *cell, const clang::ASTContext &ctx) const;
     ///////////////////////////////////////////////////////////////////////
@@ -249,6 +346,11 @@ class VrtlmodCore
     /// \brief register a possible injection location with variable
     const types::Variable *add_injection_location(const clang::MemberExpr *assignee, const clang::CXXRecordDecl *parent,
                                                   const clang::ASTContext &ctx) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief register a possible injection location with variable of given module
+    /// \param defer store the location for resolve_deferred_injection_locations if the variable is not elaborated yet
+    const types::Variable *add_injection_location(const std::string &module_id, const std::string &var_id,
+                                                  const std::string &file, int line, int column, bool defer) const;
 };
 
 } // namespace vrtlmod
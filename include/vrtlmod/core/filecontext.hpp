@@ -26,6 +26,12 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #include "clang/AST/AST.h"
 #include "clang/Rewrite/Core/Rewriter.h"
@@ -81,26 +87,51 @@ class FileContext
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Class with unique id member that is assigned by statics during construction. maps file paths to unique ids
+/// @details Files are interned in a hashed registry, ids are dense, i.e., the registration order. The registration
+/// order of parallel parse runs is arbitrary, sort_files renumbers the ids by path before they are written. Thread-safe
 class FileLocator
 {
-    static std::map<int, fs::path> file_map_;
+    static std::unordered_map<std::string, int> file_ids_; ///< file ids by path
+    static std::deque<fs::path> files_;                     ///< file paths by id, references are stable
+    static std::vector<int> sorted_ids_;                    ///< public ids by id of the files sorted by sort_files
+    static std::shared_mutex files_mutex_;
     int id_;
     int line_;
     int column_;
 
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns id of the file, registers the file if not yet known
+    static int intern(const fs::path &fpath);
+
   public:
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Calls func for all registered files with their public ids, in order of the ids
     static void foreach_relevant_file(const std::function<void(const std::pair<int, fs::path> &t)> &func);
-
-    std::string get_id() const
-    {
-        std::string ret = "f";
-        ret += std::to_string(id_);
-        return ret;
-    }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Renumbers the registered files by path, so that the ids do not depend on the order of (parallel) parse
+    ///        runs. Files registered afterwards get ids after the sorted ones
+    static void sort_files(void);
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns public id of the file, e.g., "f1"
+    std::string get_id() const;
     int get_line() const { return line_; }
     int get_column() const { return column_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns path of the located file
+    const fs::path &get_path() const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns location string, e.g., "f1:l42:c7"
+    std::string to_string() const
+    {
+        return get_id() + ":l" + std::to_string(line_) + ":c" + std::to_string(column_);
+    }
+    bool operator==(const FileLocator &rhs) const
+    {
+        return (id_ == rhs.id_) && (line_ == rhs.line_) && (column_ == rhs.column_);
+    }
 
-    FileLocator(fs::path fpath, int line, int column);
+    FileLocator(const fs::path &fpath, int line, int column) : id_(intern(fpath)), line_(line), column_(column) {}
 };
 
 } // namespace vrtlmod
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file filter.hpp
+/// @brief Filters selecting the injection targets from the injectable targets
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_CORE_FILTER_HPP__
+#define __VRTLMOD_CORE_FILTER_HPP__
+
+#include "vrtlmod/core/core.hpp"
+
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <pugixml.hpp>
+
+#include "llvm/Support/GlobPattern.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for all core vrtlmod functionalities
+namespace vrtlmod
+{
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \class Filter
+/// \brief Base class for filters generating injcetion targets for injectable targets
+struct Filter
+{
+    virtual std::unordered_set<const types::Target *> apply(const VrtlmodCore *core);
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns true for output ports of top-level SystemC modules, which are not supported for injections
+    static bool is_systemc_top_output(const VrtlmodCore &core, const types::Target &t);
+
+    std::unordered_set<const types::Target *> targets_{};
+    Filter(void) {}
+    virtual ~Filter(void) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \class WhiteListFilter
+/// \brief Filters injcetion targets for injectable targets by whitlist XML
+/// \details To use pass a VRTL analyze/elaborate XML file (VrtlmodCore::build_xml), with optionally deleted nodes
+struct WhiteListFilter : public Filter, public pugi::xml_tree_walker
+{
+    bool for_each(pugi::xml_node &node) override;
+    std::unordered_set<const types::Target *> apply(const VrtlmodCore *core) override;
+    const VrtlmodCore *core_{ nullptr };
+    fs::path fpath_;
+    std::unordered_map<VrtlmodCore::IdPair, const types::Target *, VrtlmodCore::IdPairHash>
+        index_{}; ///< injectables by (module id, variable id), valid during apply
+    WhiteListFilter(fs::path fpath) : fpath_(fpath) {}
+    virtual ~WhiteListFilter(void) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \class RuleFilter
+/// \brief Refines the injection targets of another filter by include/exclude rules
+/// \details A rules file has one rule per line, `#` starts a comment:
+///
+///     (include|exclude) [<field><op><value> ...]
+///
+/// A rule matches a target if all of its conditions match, a rule without conditions matches all targets. Rules are
+/// applied in order to the targets of the base filter, i.e., the last matching rule decides. Fields are
+/// - `hier`: `<instance>.<variable>` for any instance of the declaring module, as in the API's target dictionary.
+///   Instances are Verilator symbol table names, i.e., hierarchy levels are separated by `__DOT__`, e.g.,
+///   `hier=*__DOT__debug.status_q` for `status_q` of `TOP__top__DOT__debug`
+/// - `module`: declaring module, e.g., `Vtop_core`
+/// - `name`: variable
+/// - `type`: `var`, `out`, or `inout`
+/// - `class`: `reg` or `undef`
+/// - `bits`: total number of bits
+///
+/// String fields take `=` (glob, e.g., `name=*_q`) or `~` (ECMAScript regex, e.g., `module~Vtop_(alu|lsu)`),
+/// `bits` takes `=`, `<`, `<=`, `>`, or `>=` and a number.
+struct RuleFilter : public Filter
+{
+    struct Condition
+    {
+        enum class Field
+        {
+            HIER,
+            MODULE,
+            NAME,
+            TYPE,
+            CLASS,
+            BITS
+        } field_;
+        enum class Op
+        {
+            GLOB,
+            REGEX,
+            EQ,
+            LT,
+            LE,
+            GT,
+            GE
+        } op_;
+        std::optional<llvm::GlobPattern> glob_{}; ///< pattern of Op::GLOB
+        std::optional<std::regex> regex_{};       ///< pattern of Op::REGEX
+        int bits_{ 0 };                           ///< operand of Field::BITS
+
+        bool match(const VrtlmodCore &core, const types::Target &t) const;
+        bool match(const std::string &value) const;
+    };
+    struct Rule
+    {
+        bool include_;
+        std::vector<Condition> conditions_;
+        bool match(const VrtlmodCore &core, const types::Target &t) const;
+    };
+
+    std::unique_ptr<Filter> base_;
+    fs::path fpath_;
+    std::vector<Rule> rules_{};
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Parses the rules file. Throws on syntax errors
+    void parse(void);
+    std::unordered_set<const types::Target *> apply(const VrtlmodCore *core) override;
+    RuleFilter(std::unique_ptr<Filter> base, fs::path fpath) : base_(std::move(base)), fpath_(fpath) {}
+    virtual ~RuleFilter(void) {}
+};
+
+} // namespace vrtlmod
+
+#endif // __VRTLMOD_CORE_FILTER_HPP__
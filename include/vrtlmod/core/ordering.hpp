@@ -0,0 +1,62 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file ordering.hpp
+/// @brief Stable orderings of the VRTL analysis nodes
+/// @details Containers of modules, cells, variables, and targets are ordered by ids instead of by address, so that
+/// iterating them, and thereby all generated code, is identical for identical inputs
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_CORE_ORDERING_HPP__
+#define __VRTLMOD_CORE_ORDERING_HPP__
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief namespace for all core vrtlmod functionalities
+namespace vrtlmod
+{
+namespace types
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Orders (pointers to) nodes by id. Ids are unique within the owning container, e.g., variables of a module
+struct IdLess
+{
+    template <typename ptr_t>
+    bool operator()(const ptr_t &lhs, const ptr_t &rhs) const
+    {
+        return lhs->get_id() < rhs->get_id();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Orders (pointers to) targets by (declaring module id, variable id), i.e., the key of the lookup indexes of
+/// VrtlmodCore
+struct TargetLess
+{
+    template <typename ptr_t>
+    bool operator()(const ptr_t &lhs, const ptr_t &rhs) const
+    {
+        const auto &lhs_module = lhs->get_parent().get_id();
+        const auto &rhs_module = rhs->get_parent().get_id();
+        return (lhs_module != rhs_module) ? (lhs_module < rhs_module) : (lhs->get_id() < rhs->get_id());
+    }
+};
+
+} // namespace types
+} // namespace vrtlmod
+
+#endif // __VRTLMOD_CORE_ORDERING_HPP__
@@ -25,14 +25,19 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
-
-#include <pugixml.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
 #include "vrtlmod/core/filecontext.hpp"
+#include "vrtlmod/core/ordering.hpp"
 
 #include "vrtlmod/util/logging.hpp"
+#include "vrtlmod/util/utility.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief namespace for all core vrtlmod functionalities
@@ -47,17 +52,25 @@ class VrtlmodCore;
 namespace types
 {
 
-struct NNode : public pugi::xml_node
+////////////////////////////////////////////////////////////////////////////////
+/// @class NNode
+/// @brief Named node of the VRTL analysis. Names and ids are interned (util::strhelp::intern), i.e., equal strings
+/// share the same address
+struct NNode
 {
-    virtual std::string get_id(void) const { return pugi::xml_node::attribute("id").value(); }
-    virtual std::string get_name(void) const { return pugi::xml_node::name(); }
+  protected:
+    const std::string *name_; ///< kind of node, i.e., its element name in the VRTL analysis XML
+    const std::string *id_;   ///< identifier
+
+  public:
+    virtual const std::string &get_id(void) const { return *id_; }
+    virtual const std::string &get_name(void) const { return *name_; }
 
-    virtual void set_id(const std::string &id)
+    virtual void set_id(const std::string &id) { id_ = &util::strhelp::intern(id); }
+    NNode(const std::string &name, const std::string &id)
+        : name_(&util::strhelp::intern(name)), id_(&util::strhelp::intern(id))
     {
-        pugi::xml_node::remove_attribute("id");
-        pugi::xml_node::append_attribute("id") = id.c_str();
     }
-    NNode(const pugi::xml_node &xml_node) : pugi::xml_node(xml_node) {}
     virtual ~NNode() {}
 };
 
@@ -70,46 +83,36 @@ struct NNode : public pugi::xml_node
 
 struct Locatable : public NNode
 {
-    std::unique_ptr<FileLocator> decl_loc_{};              ///< found declaration location
-    std::vector<std::unique_ptr<FileLocator>> sea_locs_{}; ///< found sequential assignment locations
-
-    virtual std::string get_decl_loc(void) const { return pugi::xml_node::attribute("decl_loc").value(); }
-    virtual std::string get_inj_loc(void) const { return pugi::xml_node::attribute("inj_loc").value(); }
+    std::optional<FileLocator> decl_loc_{}; ///< found declaration location
+    std::vector<FileLocator> sea_locs_{};   ///< found sequential assignment locations
 
-    virtual void set_decl_loc(const std::string &id, unsigned line, unsigned column)
-    {
-        pugi::xml_node::remove_attribute("decl_loc");
-        pugi::xml_node::append_attribute("decl_loc") =
-            util::concat(id, ":l", std::to_string(line), ":c", std::to_string(column)).c_str();
-    }
-
-    virtual void set_inj_loc(const std::string &id, unsigned line, unsigned column)
-    {
-        pugi::xml_node::remove_attribute("inj_loc");
-        pugi::xml_node::append_attribute("inj_loc") =
-            util::concat(id, ":l", std::to_string(line), ":c", std::to_string(column)).c_str();
-    }
-
-    virtual void append_inj_loc(const std::string &id, unsigned line, unsigned column)
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns declaration location string, e.g., "f1:l42:c7". Empty if not declared
+    virtual std::string get_decl_loc(void) const { return decl_loc_ ? decl_loc_->to_string() : ""; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns list string of all injection locations, e.g., "[f1:l42:c7, f1:l50:c7]". Empty if none
+    virtual std::string get_inj_loc(void) const
     {
-        std::string old = get_inj_loc();
-        if (old != "")
+        if (sea_locs_.empty())
         {
-            util::strhelp::replaceAll(old, "]", "");
-            util::strhelp::replaceAll(old, "[", "");
-            old += ", ";
+            return "";
         }
-        pugi::xml_node::remove_attribute("inj_loc");
-        pugi::xml_node::append_attribute("inj_loc") =
-            util::concat("[", old, id, ":l", std::to_string(line), ":c", std::to_string(column), "]").c_str();
+        std::string ret = "[";
+        for (const auto &loc : sea_locs_)
+        {
+            ret += (ret.size() > 1) ? ", " : "";
+            ret += loc.to_string();
+        }
+        return ret + "]";
     }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns true if at least one injection location was found
+    bool has_inj_loc(void) const { return !sea_locs_.empty(); }
 
     void add_decl_loc(const std::string &file, int line, int column)
     {
-        auto loc = std::make_unique<FileLocator>(file, line, column);
-        LOG_VERBOSE("decl file: [", loc->get_id(), "]", file);
-        set_decl_loc(loc->get_id(), loc->get_line(), loc->get_column());
-        decl_loc_ = std::move(loc);
+        decl_loc_.emplace(file, line, column);
+        LOG_VERBOSE("decl file: [", decl_loc_->get_id(), "]", file);
     }
     void add_decl_loc(const llvm::StringRef &file, int line, int column)
     {
@@ -117,32 +120,36 @@ struct Locatable : public NNode
     }
     void add_inj_loc(const std::string &file, int line, int column, bool indirect = false)
     {
-        auto loc = std::make_unique<FileLocator>(file, line, column);
-        LOG_VERBOSE("inj file: [", loc->get_id(), "]", file);
-        append_inj_loc(loc->get_id(), loc->get_line(), loc->get_column());
-        sea_locs_.push_back(std::move(loc));
+        sea_locs_.emplace_back(file, line, column);
+        LOG_VERBOSE("inj file: [", sea_locs_.back().get_id(), "]", file);
     }
     void add_inj_loc(const llvm::StringRef &file, int line, int column, bool indirect = false)
     {
         add_inj_loc(std::string(file), line, column, indirect);
     }
-    Locatable(const pugi::xml_node &xml_node) : NNode(xml_node) {}
+    Locatable(const std::string &name, const std::string &id) : NNode(name, id) {}
     virtual ~Locatable() {}
 };
 
+struct Module;
+
 struct Cell : public Locatable //, public Ancestral<Cell>
 {
-    virtual std::string get_type(void) const { return pugi::xml_node::attribute("type").value(); }
-    virtual std::string get_hierarchy(void) const { return pugi::xml_node::attribute("vHier").value(); }
+  protected:
+    const std::string *type_; ///< type, i.e., module id, of the cell
+    const Module *parent_;    ///< module declaring the cell, nullptr for the top cell
+
+  public:
+    virtual const std::string &get_type(void) const { return *type_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Get parent (module declaring the cell), nullptr for the top cell
+    const Module *get_parent(void) const { return parent_; }
 
-    Cell(const pugi::xml_node &xml_node) : Locatable(xml_node) //, Ancestral<Cell>()
+    Cell(const std::string &id, const std::string &type, const Module *parent = nullptr)
+        : Locatable("cell", id), type_(&util::strhelp::intern(type)), parent_(parent) //, Ancestral<Cell>()
     {
-        std::string name = get_name();
-        if (name != "cell")
-        {
-            LOG_ERROR("Cell `<", name, "> ", NNode::get_id(), "[", get_type(), "]` is not a <cell>!");
-        }
     }
+    bool operator==(const Cell &rhs) const { return this == &rhs; }
     Cell(const Cell &) = delete;
     Cell(const Cell &&) = delete;
 };
@@ -153,32 +160,17 @@ struct Module final : public Locatable
 {
     std::set<std::string> symboltable_instances_;
 
-    std::set<std::unique_ptr<types::Variable>> variables_;
-    std::set<std::unique_ptr<types::Cell>> cells_;
+    std::set<std::unique_ptr<types::Variable>, IdLess> variables_; ///< variables by id
+    std::set<std::unique_ptr<types::Cell>, IdLess> cells_;         ///< cells by id
 
     void add_variable(std::unique_ptr<types::Variable> var) { variables_.insert(std::move(var)); }
     void add_cell(std::unique_ptr<types::Cell> cell) { cells_.insert(std::move(cell)); }
 
     void add_instance(std::string instance) { symboltable_instances_.insert(instance); }
 
-    Module(const pugi::xml_node &xml_node) : Locatable(xml_node)
-    {
-        std::string name = get_name();
-        if (name != "module")
-        {
-            LOG_ERROR("Module `<", name, "> ", NNode::get_id(), "` is not a <module>!");
-        }
-    }
+    Module(const std::string &id) : Locatable("module", id) {}
 
-    virtual bool operator==(const Module &rhs) const
-    {
-        auto d = get_decl_loc();
-        auto _d = rhs.get_decl_loc();
-        auto i = get_id();
-        auto _i = rhs.get_id();
-        bool ret = (d == _d) && (i == _i);
-        return ret;
-    }
+    virtual bool operator==(const Module &rhs) const { return (id_ == rhs.id_) && (decl_loc_ == rhs.decl_loc_); }
 
     Module(const Module &) = delete;
 };
@@ -193,33 +185,79 @@ struct Variable : public Locatable //, public Ancestral<Module>
         VAR
     };
 
-    virtual std::string get_class(void) const { return get_inj_loc() != "" ? "undef" : "reg"; }
-    virtual int get_bits(void) const { return boost::lexical_cast<int>(pugi::xml_node::attribute("bits").value()); }
-    virtual std::string get_bases(void) const { return pugi::xml_node::attribute("bases").value(); }
-    virtual std::string get_dimensions(void) const { return pugi::xml_node::attribute("dim").value(); }
-    virtual std::string get_cxx_type(void) const { return pugi::xml_node::attribute("cxx_type").value(); }
-    virtual std::string get_type(void) const { return get_name(); }
+  protected:
+    const std::string *bases_;    ///< base types of dimensions, e.g., "[VlUnpacked<CData, 7>, CData]"
+    const std::string *dim_;      ///< dimensions, e.g., "[7, 3:0]"
+    const std::string *cxx_type_; ///< declared C++ type
+    int bits_;                    ///< total number of bits
+    const Module *parent_;        ///< module declaring the variable
 
-    Variable(const pugi::xml_node &xml_node) : Locatable(xml_node) //, Ancestral<Module>(parent)
+  public:
+    virtual std::string get_class(void) const { return has_inj_loc() ? "undef" : "reg"; }
+    virtual int get_bits(void) const { return bits_; }
+    virtual const std::string &get_bases(void) const { return *bases_; }
+    virtual const std::string &get_dimensions(void) const { return *dim_; }
+    virtual const std::string &get_cxx_type(void) const { return *cxx_type_; }
+    virtual const std::string &get_type(void) const { return get_name(); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Get parent (module declaring the signal/target)
+    const Module &get_parent() const { return *parent_; }
+
+    Variable(const std::string &type, const std::string &id, const std::string &bases, const std::string &dim,
+             const std::string &cxx_type, int bits, const Module &parent)
+        : Locatable(type, id)
+        , bases_(&util::strhelp::intern(bases))
+        , dim_(&util::strhelp::intern(dim))
+        , cxx_type_(&util::strhelp::intern(cxx_type))
+        , bits_(bits)
+        , parent_(&parent) //, Ancestral<Module>(parent)
     {
-        std::string name = get_name();
-        if (name != "in" && name != "out" && name != "var" && name != "inout")
+        if (type != "in" && type != "out" && type != "var" && type != "inout")
         {
-            LOG_ERROR("Element `<", name, "> ", NNode::get_id(), "[", get_cxx_type(), "]` is not a <in|out|var>!");
+            LOG_ERROR("Element `<", type, "> ", id, "[", cxx_type, "]` is not a <in|out|var>!");
         }
     }
     virtual ~Variable() {}
 
     virtual bool operator==(const Variable &rhs) const
     {
-        bool ret = (this->get_decl_loc() == rhs.get_decl_loc()) && (this->get_id() == rhs.get_id()) &&
-                   (this->get_class() == rhs.get_class()) && (this->get_bits() == rhs.get_bits()) &&
-                   (this->get_bases() == rhs.get_bases()) && (this->get_dimensions() == rhs.get_dimensions()) &&
-                   (this->get_cxx_type() == rhs.get_cxx_type()) && (this->get_type() == rhs.get_type());
+        // interned strings compare by address
+        bool ret = (decl_loc_ == rhs.decl_loc_) && (id_ == rhs.id_) && (has_inj_loc() == rhs.has_inj_loc()) &&
+                   (bits_ == rhs.bits_) && (bases_ == rhs.bases_) && (dim_ == rhs.dim_) &&
+                   (cxx_type_ == rhs.cxx_type_) && (name_ == rhs.name_);
         return ret;
     }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// @class TargetLayout
+/// @brief Typed memory layout of a target, parsed once from its `dim`, `bases` and `bits` attributes
+struct TargetLayout
+{
+    std::vector<std::string> cxx_dim_types_{}; ///< data types for unpacked types, innermost last
+    std::vector<int> cxx_dim_lengths_{};       ///< dimensions of multi-dimensional types, e.g., CData[1][5]
+    std::vector<size_t> cxx_dim_strides_{};    ///< row-major strides of cxx_dim_lengths_ in elements
+    size_t element_count_{ 1 };                ///< total number of cxx elements
+    int bits_{ 0 };                            ///< total number of bits
+    int one_dim_bits_{ 0 };                    ///< one-dimensional, i.e., element, number of bits
+    int msb_{ -1 };                            ///< zero dim most significant bit
+    int lsb_{ -1 };                            ///< zero dim least significant bit
+    bool wide_{ false };                       ///< element is packed in WData words
+    int words_{ 1 };                           ///< number of cxx words per one-dimensional element
+    unsigned long element_mask_{ 0 };          ///< mask of an element, or of a fully used word if wide_
+    unsigned long last_word_mask_{ 0 };        ///< mask of the last word of a wide_ element
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Return the mask of element at subscripts
+    unsigned long get_element_mask(std::initializer_list<size_t> subscripts) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Constructor
+    /// \param dim `dim` attribute, e.g., "['3:0', '7']"
+    /// \param bases `bases` attribute, e.g., "['CData', 'VlUnpacked<CData, 7>']"
+    /// \param bits `bits` attribute
+    TargetLayout(const std::string &dim, const std::string &bases, int bits);
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @class Target
 /// @brief Corresponds to RegPicker-Xml element information
@@ -233,29 +271,33 @@ class Target : public Variable
         UNDEF = 0
     } signalClass_t;
 
+    friend class vrtlmod::VrtlmodCore;
+
   protected:
     bool found_decl_{ false };
     bool found_assignment_{ false };
+    int index_{ -1 }; ///< index in the injection target registry of VrtlmodCore, -1 if not an injection target
 
-    const Module &parent_;
-
-    std::pair<std::vector<std::string>, std::vector<int>> get_cxx_dimensions(void) const;
-    std::vector<int> get_dimension_lengths(void) const;
+    mutable std::once_flag layout_once_{};               ///< guards lazy construction of layout_
+    mutable std::unique_ptr<const TargetLayout> layout_; ///< parsed layout, see get_layout()
 
   public:
     bool decl_rewritten_{ false };
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns dense index of this injection target, -1 if not an injection target
+    int get_index(void) const { return index_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the layout of this target. Parsed on first call, thread-safe
+    const TargetLayout &get_layout(void) const;
+    ///////////////////////////////////////////////////////////////////////
     /// \brief One-dimensional, i.e., element, number of bits
-    int get_one_dim_bits(void) const { return get_dimension_lengths().back(); }
+    int get_one_dim_bits(void) const { return get_layout().one_dim_bits_; }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Data types for unpacked types
-    std::vector<std::string> get_cxx_dimension_types(void) const;
+    const std::vector<std::string> &get_cxx_dimension_types(void) const { return get_layout().cxx_dim_types_; }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Dimensions of multi-dimensional types, e.g., CData[1][5]
-    std::vector<int> get_cxx_dimension_lengths(void) const;
-    ///////////////////////////////////////////////////////////////////////
-    /// \brief Get parent (module declaring the signal/target)
-    const Module &get_parent() const { return parent_; }
+    const std::vector<int> &get_cxx_dimension_lengths(void) const { return get_layout().cxx_dim_lengths_; }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Returns the targets hierarchy
     std::string get_hierarchy(void) const;
@@ -263,11 +305,21 @@ class Target : public Variable
     /// \brief Returns the targets undotted hierarchy ("__DOT__"s instead of "."s)
     std::string get_hierarchyDedotted(void) const;
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the type of the target's dictionary entry in namespace vrtlfi::td, e.g.,
+    ///        `OneD_TDentry<VlUnpacked<CData, 7>, CData, 7>`, empty for unsupported dimensions
+    std::string get_td_type(void) const;
+    ///////////////////////////////////////////////////////////////////////
     /// \brief Returns zero dim Most and Least significant bit
-    std::pair<int, int> get_element_msb_lsb_pair(void) const;
+    std::pair<int, int> get_element_msb_lsb_pair(void) const
+    {
+        return { get_layout().msb_, get_layout().lsb_ };
+    }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Return the elements mask
-    unsigned long get_element_mask(std::initializer_list<size_t> subscripts) const;
+    unsigned long get_element_mask(std::initializer_list<size_t> subscripts) const
+    {
+        return get_layout().get_element_mask(subscripts);
+    }
     ///////////////////////////////////////////////////////////////////////
     /// \brief Returns the number of fault injection positions
     unsigned int get_seq_assignment_count(void) const { return sea_locs_.size(); }
@@ -276,7 +328,8 @@ class Target : public Variable
     std::string _self(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Constructor
-    Target(const pugi::xml_node &xml_node, const Module &parent) : types::Variable(xml_node), parent_(parent){};
+    /// \param var Elaborated and analyzed variable
+    Target(const Variable &var) : types::Variable(var){};
     ///////////////////////////////////////////////////////////////////////
     /// \brief Destructor
     virtual ~Target(void) {}
@@ -304,9 +357,6 @@ class Target : public Variable
         bool ret = (this->get_parent() == rhs.get_parent()) && Variable::operator==(rhs);
         return ret;
     }
-    ///////////////////////////////////////////////////////////////////////
-    /// \brief Constructor
-    Target(const pugi::xml_node &xml_node, const pugi::xml_node &parent) = delete;
     Target(const Target &) = delete;
 };
 
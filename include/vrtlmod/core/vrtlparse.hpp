@@ -27,6 +27,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Rewrite/Frontend/FrontendActions.h"
@@ -39,6 +40,7 @@
 #include "vrtlmod/core/consumer.hpp"
 #include "vrtlmod/core/core.hpp"
 
+#include <map>
 #include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -56,7 +58,8 @@ class VrtlParser : public Handler
     clang::SourceLocation last_seq_compound_end_;   ///< signals if we are currently in a sequent eval function's scope
     clang::ASTContext *last_seq_compound_ctx_{ nullptr }; ///< store context pointer to invalidate inter-file matching
 
-    std::set<std::unique_ptr<VrtlmodPass>> passes_; ///< passes that extend match based action on parsed source code
+    std::vector<std::unique_ptr<VrtlmodPass>> passes_; ///< passes that extend match based action, in order of add_pass
+    std::map<std::string, size_t> match_counts_; ///< matches by binding in this translation unit (--time-report)
   public:
     template <typename llvm_expr_t>
     std::string get_source_code_str(const llvm_expr_t *expr) const;
@@ -264,7 +267,8 @@ std::pair<const clang::MemberExpr *, const clang::CXXRecordDecl *> VrtlParser::p
 ////////////////////////////////////////////////////////////////////////////////
 /// @class ParserAction
 /// @brief Frontend action for LLVM tool executing actions on the AST tree
-template <typename pass_t>
+/// @details All given passes act on the same parse run, i.e., share a single traversal of the AST
+template <typename... pass_t>
 class ParserAction : public clang::ASTFrontendAction
 {
     clang::Rewriter rewriter_;
@@ -279,23 +283,37 @@ class ParserAction : public clang::ASTFrontendAction
     std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance &CI, llvm::StringRef InFile);
 };
 
-template <typename pass_t>
-std::unique_ptr<clang::ASTConsumer> ParserAction<pass_t>::CreateASTConsumer(clang::CompilerInstance &CI,
-                                                                            llvm::StringRef InFile)
+template <typename... pass_t>
+std::unique_ptr<clang::ASTConsumer> ParserAction<pass_t...>::CreateASTConsumer(clang::CompilerInstance &CI,
+                                                                               llvm::StringRef InFile)
 {
     curfile = InFile.str();
     rewriter_.setSourceMgr(CI.getSourceManager(), CI.getLangOpts());
 
-    auto cons = std::make_unique<Consumer>(rewriter_, curfile);
-    auto pass = std::make_unique<pass_t>(core_);
+    auto cons = std::make_unique<Consumer>(rewriter_, curfile, core_.has_scoped_traversal(), core_.get_vrtl_dirs());
     auto parser = std::make_unique<VrtlParser>(*cons);
-    parser->add_pass(std::move(pass));
+    (parser->add_pass(std::make_unique<pass_t>(core_)), ...);
 
     cons->ownHandler(std::move(parser));
 
     return std::move(cons);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Executes passes on an already parsed (e.g., deserialized) AST instead of a ClangTool parse run
+/// @details Changes made by the passes are not written back
+template <typename... pass_t>
+void run_passes(VrtlmodCore &core, clang::ASTUnit &ast)
+{
+    clang::Rewriter rewriter(ast.getSourceManager(), ast.getLangOpts());
+    Consumer cons(rewriter, ast.getMainFileName().str(), core.has_scoped_traversal(), core.get_vrtl_dirs());
+    auto parser = std::make_unique<VrtlParser>(cons);
+    (parser->add_pass(std::make_unique<pass_t>(core)), ...);
+
+    cons.ownHandler(std::move(parser));
+    cons.HandleTranslationUnit(ast.getASTContext());
+}
+
 } // namespace vrtlmod
 
 #endif // __VRTLMOD_PARSE_VRTLPARSE_HPP__
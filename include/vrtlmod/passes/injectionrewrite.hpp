@@ -110,13 +110,33 @@ class InjectionRewriter final : public VrtlmodPass
     mutable std::map<const clang::FunctionDecl *, std::vector<std::shared_ptr<CompoundStmt>>> map_seq_compounds_;
     mutable const clang::FunctionDecl *active_sequent_func_{ nullptr };
     mutable CompoundStmt *active_compound_{ nullptr }; ///< active compound statement
-    std::shared_ptr<CompoundStmt> get_finest_compound(const clang::FunctionDecl *f, const clang::Expr *expr) const;
+    mutable std::vector<std::shared_ptr<CompoundStmt>> open_compounds_{}; ///< enclosing compounds, innermost last
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Records a compound of the active sequent function and makes it the innermost open compound
+    void add_compound(std::shared_ptr<CompoundStmt> compound) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the innermost compound of the active sequent function enclosing `expr`, nullptr if none
+    /// \details Compounds are matched in traversal order, i.e., before the statements they enclose. Open compounds
+    /// ending before `expr` can not enclose any later statement and are closed, so a lookup is amortized constant
+    std::shared_ptr<CompoundStmt> get_finest_compound(const clang::Expr *expr) const;
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Orders (prefix, target) pairs by prefix and target ids, i.e., the order of the emitted injections
+    struct PrefixedTargetLess
+    {
+        bool operator()(const std::pair<std::string, const types::Target *> &lhs,
+                        const std::pair<std::string, const types::Target *> &rhs) const
+        {
+            return (lhs.first != rhs.first) ? (lhs.first < rhs.first) : types::TargetLess()(lhs.second, rhs.second);
+        }
+    };
+    using PrefixedTargets = std::set<std::pair<std::string, const types::Target *>, PrefixedTargetLess>;
 
-    mutable std::map<const clang::FunctionDecl *, std::set<std::pair<std::string, const types::Target *>>>
+    mutable std::map<const clang::FunctionDecl *, PrefixedTargets>
         map_injected_targets_; ///< map keyed with sequential functions valued with pairs of targets and their
                                ///< function-local prefix, prefix is required because some Verilated functions are
                                ///< static, thus, not allowing `this->`
-    mutable std::map<const clang::FunctionDecl *, std::set<std::pair<std::string, const types::Target *>>>
+    mutable std::map<const clang::FunctionDecl *, PrefixedTargets>
         map_nonliteral_subscript_targets_; ///< map keyed with sequential functions valued with pairs of targets and
                                            ///< their function-local prefix, prefix is required because some Verilated
                                            ///< functions are static, thus, not allowing `this->`. These targets are
@@ -60,18 +60,13 @@ class RewriteMacrosAction : public clang::PreprocessorFrontendAction
     void ExecuteAction();
 };
 
-class RewriteCommentsAction : public clang::PreprocessorFrontendAction
-{
-    struct CommentHandler : clang::CommentHandler
-    {
-        llvm::StringRef file_;
-        clang::RewriteBuffer *rb_;
-        void set_file(llvm::StringRef file) { file_ = file; }
-        void set_rewrite_buffer(clang::RewriteBuffer &RB) { rb_ = &RB; }
-        bool HandleComment(clang::Preprocessor &PP, clang::SourceRange Comment) override;
-    } ch_;
-    void ExecuteAction(void) override;
-};
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Escapes multi-line comments (`/**/`) nested in comments of a file
+/// @details RewriteMacrosAction can not detect those and would result in `/* // ... /* some text */ ... */`, which breaks
+/// the preprocessor at the first `/**/` pair. Single streaming pass over the file without a Clang frontend, the file is
+/// only written if it changed. Files are independent of each other and can be processed in parallel.
+/// @return 0 on success, 1 if the file could not be read or written
+int clean_nested_comments(const std::string &file);
 
 } // namespace rewrite
 } // namespace transform
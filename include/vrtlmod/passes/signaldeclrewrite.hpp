@@ -56,13 +56,31 @@ class SignalDeclRewriter : public VrtlmodPass
     ///////////////////////////////////////////////////////////////////////
     /// \brief Constructor
     /// \param core Reference to vrtlmod core storing signal and injection data
-    SignalDeclRewriter(const VrtlmodCore &core);
+    /// \param main_file_only Only rewrite declarations in the main file of the parse run. Allows concurrent runs on
+    /// headers including each other
+    SignalDeclRewriter(const VrtlmodCore &core, bool main_file_only = true);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Destructor
     virtual ~SignalDeclRewriter(void);
 
   private:
     std::set<clang::SourceLocation> visited;
+    bool main_file_only_;                                 ///< only rewrite declarations in the main file
+    mutable std::set<clang::FileID> modified_includes_{}; ///< files of this parse run with modified includes
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @class BatchSignalDeclRewriter
+/// @brief SignalDeclRewriter acting on all files of a parse run, i.e., rewrites all VRTL headers in a single run on a
+/// translation unit including them
+////////////////////////////////////////////////////////////////////////////////
+class BatchSignalDeclRewriter : public SignalDeclRewriter
+{
+  public:
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Constructor
+    /// \param core Reference to vrtlmod core storing signal and injection data
+    BatchSignalDeclRewriter(const VrtlmodCore &core) : SignalDeclRewriter(core, false) {}
 };
 
 } // namespace passes
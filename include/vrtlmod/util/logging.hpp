@@ -29,10 +29,17 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/raw_os_ostream.h"
 
+#include <atomic>
 #include <string>
 
 #include <stdexcept>
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Compile-time minimum log level, lower levels (but OBLIGAT and ERROR) are compiled out
+#ifndef VRTLMOD_LOG_MIN_LEVEL
+#define VRTLMOD_LOG_MIN_LEVEL VERBOSE
+#endif
+
 namespace util
 {
 
@@ -48,6 +55,8 @@ enum LEVEL
     ERROR
 };
 
+constexpr LEVEL MIN_LEVEL = VRTLMOD_LOG_MIN_LEVEL;
+
 const char *toString(LEVEL level);
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Toggle silent output (false on reset)
@@ -56,8 +65,43 @@ void toggle_silent(void);
 /// \brief Toggle verbose output (false on reset)
 void toggle_verbose(void);
 ////////////////////////////////////////////////////////////////////////////////
+/// \brief Enable/disable the buffered asynchronous sink (disabled on reset). Disabling flushes the buffer
+void set_async(bool async);
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Block until all buffered messages are written
+void flush(void);
+////////////////////////////////////////////////////////////////////////////////
 /// \brief Log helper function
-void log(LEVEL level, const std::string &msg, bool silent_toggle = false, bool verbose_toggle = false);
+void log(LEVEL level, const std::string &msg);
+
+namespace detail
+{
+extern std::atomic<bool> silent;
+extern std::atomic<bool> verbose;
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns true if messages of level are logged, i.e., worth building
+template <LEVEL level>
+inline bool is_enabled(void)
+{
+    if constexpr (level == OBLIGAT || level == ERROR)
+    {
+        return true;
+    }
+    else if constexpr (level < MIN_LEVEL)
+    {
+        return false;
+    }
+    else if constexpr (level == VERBOSE)
+    {
+        return detail::verbose.load(std::memory_order_relaxed) && !detail::silent.load(std::memory_order_relaxed);
+    }
+    else
+    {
+        return !detail::silent.load(std::memory_order_relaxed);
+    }
+}
 
 template <typename T>
 std::string toLogString(const T &obj)
@@ -115,31 +159,24 @@ void LOG(Strings &&...strings)
 
 } // namespace util
 
-template <typename... Strings>
-void LOG_VERBOSE(Strings &&...strings)
-{
-    util::logging::LOG<util::logging::VERBOSE>(std::forward<Strings>(strings)...);
-}
-template <typename... Strings>
-void LOG_INFO(Strings &&...strings)
-{
-    util::logging::LOG<util::logging::INFO>(std::forward<Strings>(strings)...);
-}
-template <typename... Strings>
-void LOG_ERROR(Strings &&...strings)
-{
-    util::logging::LOG<util::logging::ERROR>(std::forward<Strings>(strings)...);
-}
-template <typename... Strings>
-void LOG_OBLIGAT(Strings &&...strings)
-{
-    util::logging::LOG<util::logging::OBLIGAT>(std::forward<Strings>(strings)...);
-}
-template <typename... Strings>
-void LOG_WARNING(Strings &&...strings)
-{
-    util::logging::LOG<util::logging::WARNING>(std::forward<Strings>(strings)...);
-}
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Logs the concatenation of the arguments. Arguments are only evaluated if the level is enabled, i.e., are
+/// free for disabled levels, e.g., AST dumps in LOG_VERBOSE
+#define VRTLMOD_LOG(level, ...)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (util::logging::is_enabled<level>())                                                                        \
+        {                                                                                                              \
+            util::logging::LOG<level>(__VA_ARGS__);                                                                    \
+        }                                                                                                              \
+    } while (0)
+
+#define LOG_VERBOSE(...) VRTLMOD_LOG(util::logging::VERBOSE, __VA_ARGS__)
+#define LOG_INFO(...) VRTLMOD_LOG(util::logging::INFO, __VA_ARGS__)
+#define LOG_ERROR(...) VRTLMOD_LOG(util::logging::ERROR, __VA_ARGS__)
+#define LOG_OBLIGAT(...) VRTLMOD_LOG(util::logging::OBLIGAT, __VA_ARGS__)
+#define LOG_WARNING(...) VRTLMOD_LOG(util::logging::WARNING, __VA_ARGS__)
+
 template <typename... Strings>
 void LOG_FATAL(Strings &&...strings)
 {
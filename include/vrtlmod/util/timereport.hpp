@@ -0,0 +1,124 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file timereport.hpp
+/// @brief Self-profiling of vrtlmod runs (--time-report)
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRTLMOD_UTIL_TIMEREPORT_HPP__
+#define __VRTLMOD_UTIL_TIMEREPORT_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+namespace util
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Records wall and CPU time, and peak RSS of the stages of a run, timings of the files processed in each
+/// stage, and matcher binding counts of parse runs. Disabled (and free of cost) unless enabled
+class TimeReport
+{
+  public:
+    struct FileSample
+    {
+        std::string file_;
+        double wall_s_; ///< wall time in seconds
+        double cpu_s_;  ///< CPU time of the processing thread in seconds
+    };
+    struct StageSample
+    {
+        std::string name_;
+        double wall_s_;                         ///< wall time in seconds
+        double cpu_s_;                          ///< CPU time of all threads in seconds
+        long peak_rss_kb_;                      ///< peak resident set size at the end of the stage in KiB
+        std::vector<FileSample> files_;         ///< per file (translation unit) timings
+        std::map<std::string, size_t> matches_; ///< match counts by matcher binding
+    };
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Measures a stage from construction to destruction
+    class Stage
+    {
+        int index_{ -1 }; ///< index of the stage sample, -1 if disabled
+        std::chrono::steady_clock::time_point wall_;
+        double cpu_s_;
+
+      public:
+        Stage(const std::string &name);
+        ~Stage(void);
+        Stage(const Stage &) = delete;
+    };
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Measures the processing of a file of the current stage from construction to destruction
+    class File
+    {
+        std::string file_;
+        std::chrono::steady_clock::time_point wall_;
+        double cpu_s_;
+
+      public:
+        File(const std::string &file);
+        ~File(void);
+        File(const File &) = delete;
+    };
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Enables the report on construction and writes it on destruction, i.e., on any return of a run
+    class Writer
+    {
+        fs::path file_;
+
+      public:
+        Writer(const fs::path &file);
+        ~Writer(void);
+        Writer(const Writer &) = delete;
+    };
+
+  private:
+    std::atomic<bool> enabled_{ false };
+    mutable std::mutex mutex_;
+    std::vector<StageSample> stages_{};
+    int current_{ -1 }; ///< index of the currently measured stage, -1 outside of stages
+    std::chrono::steady_clock::time_point start_{};
+
+  public:
+    static TimeReport &get(void);
+    static double process_cpu_s(void);
+    static double thread_cpu_s(void);
+    static long peak_rss_kb(void);
+
+    void enable(void);
+    bool is_enabled(void) const { return enabled_.load(std::memory_order_relaxed); }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Add matcher binding counts (of a translation unit) to the current stage
+    void add_matches(const std::map<std::string, size_t> &matches);
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Write the report as JSON
+    bool write(const fs::path &file) const;
+};
+
+} // namespace util
+
+#endif // __VRTLMOD_UTIL_TIMEREPORT_HPP__
@@ -29,12 +29,19 @@
 
 #include "vrtlmod/vapi/templates/templatefile.hpp"
 
+#include <set>
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief namespace for all core vrtlmod functionalities
 namespace vrtlmod
 {
 
 class VrtlmodCore;
+namespace types
+{
+class Target;
+} // namespace types
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief namespace for all API building functionalities
@@ -63,8 +70,26 @@ class VapiGenerator
         std::string get_details(void) const { return "automatically generated file"; }
         std::string get_author(void) const { return util::concat("vrtlmod::vapi::VapiSource v", get_version()); }
         std::string generate_body(void) const;
+        void write_body(std::ostream &os) const;
     } vapisrc_{ *this };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Part of the API source holding the target dictionary entries of one range of target ids. Written if
+    ///        the API is sharded (see set_api_shards), so that the API compiles in parallel
+    class VapiSourceShard final : public TemplateFile
+    {
+        const VapiGenerator &gen_;
+        unsigned shard_;
+
+      public:
+        VapiSourceShard(const VapiGenerator &gen, unsigned shard) : gen_(gen), shard_(shard) {}
+        std::string get_brief(void) const { return "vrtlmod api source shard"; }
+        std::string get_details(void) const { return "automatically generated file"; }
+        std::string get_author(void) const { return util::concat("vrtlmod::vapi::VapiSourceShard v", get_version()); }
+        std::string generate_body(void) const;
+        void write_body(std::ostream &os) const;
+    };
+
     class VapiHeader final : public TemplateFile
     {
         VapiGenerator &gen_;
@@ -77,6 +102,41 @@ class VapiGenerator
         std::string generate_body(void) const;
     } vapiheader_{ *this };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Explicit instantiation declarations of all target dictionary entry types (see
+    ///        VrtlmodCore::set_td_instances), included by the instrumented VRTL headers
+    class TDInstancesHeader final : public TemplateFile
+    {
+        VapiGenerator &gen_;
+
+      public:
+        TDInstancesHeader(VapiGenerator &gen) : gen_(gen) {}
+        std::string get_brief(void) const { return "vrtlmod target dictionary entry instantiation declarations"; }
+        std::string get_details(void) const { return "automatically generated file"; }
+        std::string get_author(void) const
+        {
+            return util::concat("vrtlmod::vapi::TDInstancesHeader v", get_version());
+        }
+        std::string generate_body(void) const;
+    } tdinstancesheader_{ *this };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Explicit instantiation definitions of all target dictionary entry types
+    class TDInstancesSource final : public TemplateFile
+    {
+        VapiGenerator &gen_;
+
+      public:
+        TDInstancesSource(VapiGenerator &gen) : gen_(gen) {}
+        std::string get_brief(void) const { return "vrtlmod target dictionary entry instantiations"; }
+        std::string get_details(void) const { return "automatically generated file"; }
+        std::string get_author(void) const
+        {
+            return util::concat("vrtlmod::vapi::TDInstancesSource v", get_version());
+        }
+        std::string generate_body(void) const;
+    } tdinstancessrc_{ *this };
+
     class TDHeader final : public TemplateFile
     {
         VapiGenerator &gen_;
@@ -96,10 +156,51 @@ class VapiGenerator
 
     std::vector<std::string> prepare_files(const std::vector<std::string> &files,
                                            const std::vector<std::string> &file_ext_matchers, bool overwrite);
+
+  public:
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Target dictionary entry of the API, i.e., an injection target in one symbol table instance of its module
+    struct TargetEntry
+    {
+        const types::Target *t_;
+        std::string prefix_; ///< symbol table prefix of the instance
+        std::string member_; ///< member access from the VRTL top, e.g., `rootp->vlSymsp->TOP__core.x`
+        size_t elements_;    ///< number of unrolled elements in the compare functions
+    };
+
+  private:
     const VrtlmodCore &core_;
+    unsigned api_shards_{ 1 };           ///< number of translation units the API source is split into
+    unsigned jobs_{ 1 };                 ///< number of threads generating the API sources, 0 for all cores
+    bool compare_table_{ false };        ///< generate table-driven instead of unrolled compare functions
+    std::vector<TargetEntry> entries_{}; ///< target dictionary entries by target id, valid during build_api
+    std::vector<size_t> shard_bounds_{}; ///< entry ranges of the API source shards, valid during build_api
+
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Collects the target dictionary entries and the shard bounds from the core, in a single pass
+    void collect_entries(void);
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Removes API source shards in api_dir that are not part of this API, e.g., of a previous run with more
+    ///        shards
+    void remove_stale_shards(const fs::path &api_dir) const;
 
   public:
     const VrtlmodCore &get_core() const { return core_; }
+    unsigned get_api_shards(void) const { return api_shards_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Split the API source into the main source and `shards` source shards, 1 for a single source
+    void set_api_shards(unsigned shards) { api_shards_ = (shards > 0) ? shards : 1; }
+    unsigned get_jobs(void) const { return jobs_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Generate the API sources with `jobs` threads, 0 for all cores
+    void set_jobs(unsigned jobs) { jobs_ = jobs; }
+    bool get_compare_table(void) const { return compare_table_; }
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Generate the compare functions of the Differential as loops over a descriptor table per target
+    ///        (vrtlfi::td::CompareDescriptor) instead of unrolled per-element code
+    void set_compare_table(bool compare_table) { compare_table_ = compare_table; }
+    const std::vector<TargetEntry> &get_entries(void) const { return entries_; }
+    const std::vector<size_t> &get_shard_bounds(void) const { return shard_bounds_; }
 
   public:
     std::string get_targetdictionary_filename(void) const { return (API_TD_HEADER_NAME); }
@@ -107,11 +208,25 @@ class VapiGenerator
     std::string get_apiheader_filename(void) const;
     std::string get_apisource_filename(void) const;
     ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns file name of an API source shard, e.g., `Vtop_vrtlmodapi_0.cpp`
+    std::string get_apisource_shard_filename(unsigned shard) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns file name of the target dictionary entry instantiation declarations, e.g.,
+    ///        `Vtop_td_instances.hpp`
+    std::string get_td_instances_header_filename(void) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns file name of the target dictionary entry instantiations, e.g., `Vtop_td_instances.cpp`
+    std::string get_td_instances_source_filename(void) const;
+    ///////////////////////////////////////////////////////////////////////
+    /// \brief Returns the target dictionary entry types of all injection targets, and their bases, in namespace
+    ///        vrtlfi::td. Types of SystemC ports are omitted, they are instantiated implicitly
+    std::set<std::string> get_td_instances(void) const;
+    ///////////////////////////////////////////////////////////////////////
     /// \brief Returns String containing the include macros for API
     std::string getInludeStrings(void) const;
     ///////////////////////////////////////////////////////////////////////
     /// \brief Build API: vrtlmod (.cpp/.hpp) and InjAPI to specified output directory
-    int build_api(void) const;
+    int build_api(void);
     ///////////////////////////////////////////////////////////////////////
     /// \brief Build API: Target dictionary (targetdictionary.hpp)
     int build_targetdictionary(void) const;
@@ -26,7 +26,10 @@
 #include <sstream>
 #include <fstream>
 #include <chrono>
+#include <cstdlib>
 #include <ctime>
+#include <iomanip>
+#include <vector>
 
 #include "vrtlmod/util/logging.hpp"
 
@@ -48,10 +51,20 @@ class TemplateFile
   protected:
     virtual std::string get_brief(void) const { return (std::string("")); }
     virtual std::string get_details(void) const { return (std::string("")); }
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Date of SOURCE_DATE_EPOCH, if set, otherwise empty. Generated files do not carry the time of generation,
+    ///        so that identical inputs give identical files
     virtual std::string get_date(void) const
     {
-        std::time_t timestamp = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        return (std::ctime(&timestamp));
+        const char *epoch = std::getenv("SOURCE_DATE_EPOCH");
+        if (epoch == nullptr)
+        {
+            return (std::string(""));
+        }
+        std::time_t timestamp = std::strtoll(epoch, nullptr, 10);
+        std::stringstream x;
+        x << std::put_time(std::gmtime(&timestamp), "%Y-%m-%d %X");
+        return (x.str());
     }
     virtual std::string get_author(void) const { return (std::string("")); }
 
@@ -60,10 +73,12 @@ class TemplateFile
         std::stringstream x;
         x << "////////////////////////////////////////////////////////////////////////////////\n\
 /// @file "
-          << filename << "\n\
-/// @date "
-          << get_date() << "\
-/// @author "
+          << filename << "\n";
+        if (auto date = get_date(); !date.empty())
+        {
+            x << "/// @date " << date << "\n";
+        }
+        x << "/// @author "
           << get_author() << "\n\
 /// @brief "
           << get_brief() << "\n\
@@ -74,6 +89,9 @@ class TemplateFile
         return x.str();
     };
     virtual std::string generate_body(void) const = 0;
+    ////////////////////////////////////////////////////////////////////////////////
+    /// \brief Writes the body to `os`. Overridden by large files to stream the body instead of building it in memory
+    virtual void write_body(std::ostream &os) const { os << generate_body(); }
 
   public:
     ////////////////////////////////////////////////////////////////////////////////
@@ -87,7 +105,9 @@ class TemplateFile
         auto filename = (fpathstr.rfind("/") != std::string::npos)    ? fpathstr.substr(fpathstr.rfind("/") + 1)
                         : (fpathstr.rfind("\\") != std::string::npos) ? fpathstr.substr(fpathstr.rfind("\\") + 1)
                                                                       : fpathstr;
+        std::vector<char> buffer(1 << 20);
         std::ofstream out;
+        out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
         LOG_INFO("TemplateFile file path: [", fpathstr, "] open.");
         out.open(fpathstr);
         if (out.fail())
@@ -95,7 +115,7 @@ class TemplateFile
             LOG_FATAL("TemplateFile file path: [", fpathstr, "] invalid.");
         }
         out << generate_header(filename);
-        out << generate_body();
+        write_body(out);
         out.close();
         LOG_INFO("TemplateFile file path: [", fpathstr, "] written.");
     }
@@ -22,6 +22,7 @@
 #ifndef __VRTLMOD_VRTLMOD_HPP__
 #define __VRTLMOD_VRTLMOD_HPP__
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -32,6 +33,7 @@ namespace tooling
 class ToolAction;
 }
 class FrontendActionFactory;
+class ASTUnit;
 } // namespace clang
 
 namespace vrtlmod
@@ -42,12 +44,24 @@ class VrtlmodCore;
 const std::string &get_version(void);
 
 std::unique_ptr<clang::tooling::ToolAction> CreateMacroRewritePass(VrtlmodCore &core);
-std::unique_ptr<clang::tooling::ToolAction> CreateCommentRewritePass(VrtlmodCore &core);
 std::unique_ptr<clang::tooling::ToolAction> CreateElaboratePass(VrtlmodCore &core);
 std::unique_ptr<clang::tooling::ToolAction> CreateAnalyzePass(VrtlmodCore &core);
+///////////////////////////////////////////////////////////////////////
+/// \brief Elaborate and analyze pass sharing a single parse run
+/// \details Needs VrtlmodCore::defer_injection_locations and VrtlmodCore::resolve_deferred_injection_locations
+std::unique_ptr<clang::tooling::ToolAction> CreateElaborateAnalyzePass(VrtlmodCore &core);
 std::unique_ptr<clang::tooling::ToolAction> CreateSignalDeclPass(VrtlmodCore &core);
+///////////////////////////////////////////////////////////////////////
+/// \brief Signal declaration pass rewriting all files of a parse run, e.g., a translation unit including all headers
+std::unique_ptr<clang::tooling::ToolAction> CreateBatchSignalDeclPass(VrtlmodCore &core);
 std::unique_ptr<clang::tooling::ToolAction> CreateInjectionPass(VrtlmodCore &core);
 
+///////////////////////////////////////////////////////////////////////
+/// \brief Pass acting on an already parsed AST, e.g., loaded from an ASTCache
+using ASTPass = std::function<void(clang::ASTUnit &)>;
+ASTPass CreateElaborateASTPass(VrtlmodCore &core);
+ASTPass CreateAnalyzeASTPass(VrtlmodCore &core);
+
 } // namespace vrtlmod
 
 #endif /* __VRTLMOD_VRTLMOD_HPP__ */
@@ -0,0 +1,348 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file analysisdb.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/core/analysisdb.hpp"
+#include "vrtlmod/core/core.hpp"
+#include "vrtlmod/core/types.hpp"
+#include "vrtlmod/util/logging.hpp"
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace vrtlmod
+{
+
+namespace
+{
+
+static_assert(sizeof(analysisdb::Header) % sizeof(uint32_t) == 0, "unaligned database record");
+static_assert(sizeof(analysisdb::Location) % sizeof(uint32_t) == 0, "unaligned database record");
+static_assert(sizeof(analysisdb::Cell) % sizeof(uint32_t) == 0, "unaligned database record");
+static_assert(sizeof(analysisdb::Module) % sizeof(uint32_t) == 0, "unaligned database record");
+static_assert(sizeof(analysisdb::Variable) % sizeof(uint32_t) == 0, "unaligned database record");
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Collects the string table and the records of a database
+class DBWriter
+{
+    std::unordered_map<std::string, uint32_t> string_ids_{};
+    std::vector<std::string> strings_{};
+    std::vector<char> body_{};
+
+  public:
+    uint32_t add_string(const std::string &str)
+    {
+        auto it = string_ids_.emplace(str, strings_.size());
+        if (it.second)
+        {
+            strings_.push_back(str);
+        }
+        return it.first->second;
+    }
+
+    analysisdb::Location get_location(const std::optional<FileLocator> &loc)
+    {
+        if (!loc)
+        {
+            return { analysisdb::NONE, 0, 0 };
+        }
+        return get_location(*loc);
+    }
+    analysisdb::Location get_location(const FileLocator &loc)
+    {
+        return { add_string(loc.get_path().string()), static_cast<uint32_t>(loc.get_line()),
+                 static_cast<uint32_t>(loc.get_column()) };
+    }
+
+    template <typename record_t>
+    void add_record(const record_t &record)
+    {
+        const char *data = reinterpret_cast<const char *>(&record);
+        body_.insert(body_.end(), data, data + sizeof(record_t));
+    }
+
+    bool write(const fs::path &file, analysisdb::Header header)
+    {
+        std::vector<uint32_t> offsets{ 0 };
+        std::string data;
+        for (const auto &str : strings_)
+        {
+            data += str;
+            offsets.push_back(data.size());
+        }
+        header.string_count_ = strings_.size();
+        header.string_size_ = data.size();
+        data.resize((data.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t), '\0');
+
+        std::error_code ec;
+        llvm::raw_fd_ostream os(file.string(), ec);
+        if (ec)
+        {
+            LOG_ERROR("Could not open analysis database [", file.string(), "] for writing: ", ec.message());
+            return false;
+        }
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint32_t));
+        os.write(data.data(), data.size());
+        os.write(body_.data(), body_.size());
+        os.close();
+        if (os.has_error())
+        {
+            // a pending error would make the stream's destructor abort
+            LOG_ERROR("Could not write analysis database [", file.string(), "]: ", os.error().message());
+            os.clear_error();
+            return false;
+        }
+        return true;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Reads records in place from a memory-mapped database. Throws on truncated or corrupt databases
+class DBReader
+{
+    const fs::path file_;
+    const char *pos_;
+    const char *end_;
+    const uint32_t *offsets_{ nullptr };
+    const char *strings_{ nullptr };
+    uint32_t string_count_{ 0 };
+
+  public:
+    template <typename record_t>
+    const record_t *next(size_t count = 1)
+    {
+        if (count > static_cast<size_t>(end_ - pos_) / sizeof(record_t))
+        {
+            LOG_FATAL("Analysis database [", file_.string(), "] is truncated");
+        }
+        auto ret = reinterpret_cast<const record_t *>(pos_);
+        pos_ += sizeof(record_t) * count;
+        return ret;
+    }
+
+    void read_string_table(const analysisdb::Header &header)
+    {
+        // counts are computed in size_t, a corrupt header must not wrap them around. next checks them against the
+        // remaining database before anything is read
+        const size_t offset_count = static_cast<size_t>(header.string_count_) + 1;
+        const size_t string_size =
+            (static_cast<size_t>(header.string_size_) + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+        string_count_ = header.string_count_;
+        offsets_ = next<uint32_t>(offset_count);
+        strings_ = next<char>(string_size);
+        for (uint32_t i = 0; i < string_count_; ++i)
+        {
+            if (offsets_[i] > offsets_[i + 1] || offsets_[i + 1] > header.string_size_)
+            {
+                LOG_FATAL("Analysis database [", file_.string(), "] has a corrupt string table");
+            }
+        }
+    }
+
+    std::string get_string(uint32_t id) const
+    {
+        if (id >= string_count_)
+        {
+            LOG_FATAL("Analysis database [", file_.string(), "] refers to unknown string ", std::to_string(id));
+        }
+        return std::string(strings_ + offsets_[id], offsets_[id + 1] - offsets_[id]);
+    }
+
+    void set_decl_loc(types::Locatable &l, const analysisdb::Location &loc) const
+    {
+        if (loc.file_ != analysisdb::NONE)
+        {
+            l.add_decl_loc(get_string(loc.file_), loc.line_, loc.column_);
+        }
+    }
+
+    DBReader(const fs::path &file, const llvm::MemoryBuffer &buffer)
+        : file_(file), pos_(buffer.getBufferStart()), end_(buffer.getBufferEnd())
+    {
+    }
+};
+
+} // namespace
+
+fs::path VrtlmodCore::get_analysis_db_path(void) const
+{
+    std::string top_name = get_top_cell().get_type();
+#if VRTLMOD_VERILATOR_VERSION <= 4204
+
+#else // VRTLMOD_VERILATOR_VERSION <= 4228
+    util::strhelp::replace(top_name, "___024root", "");
+#endif
+    return out_dir_path_ / (top_name + "-vrtlmod.db");
+}
+
+bool VrtlmodCore::write_analysis_db(const fs::path &file) const
+{
+    auto lock = lock_ctx();
+    DBWriter db;
+    analysisdb::Header header{};
+    std::memcpy(header.magic_, analysisdb::MAGIC, sizeof(header.magic_));
+    header.format_version_ = analysisdb::FORMAT_VERSION;
+    header.version_ = db.add_string(VRTLMOD_VERSION);
+    header.has_top_cell_ = ctx_->top_cell_ ? 1 : 0;
+    header.module_count_ = ctx_->modules_.size();
+
+    auto get_cell = [&](const types::Cell &c) -> analysisdb::Cell
+    {
+        return { db.add_string(c.get_id()), db.add_string(c.get_type()), db.get_location(c.decl_loc_) };
+    };
+
+    if (ctx_->top_cell_)
+    {
+        db.add_record(get_cell(*ctx_->top_cell_));
+    }
+    for (const auto &m : ctx_->modules_)
+    {
+        db.add_record(analysisdb::Module{ db.add_string(m->get_id()), db.get_location(m->decl_loc_),
+                                          static_cast<uint32_t>(m->symboltable_instances_.size()),
+                                          static_cast<uint32_t>(m->cells_.size()),
+                                          static_cast<uint32_t>(m->variables_.size()) });
+        for (const auto &instance : m->symboltable_instances_)
+        {
+            db.add_record(db.add_string(instance));
+        }
+        for (const auto &c : m->cells_)
+        {
+            db.add_record(get_cell(*c));
+        }
+        for (const auto &v : m->variables_)
+        {
+            db.add_record(analysisdb::Variable{
+                db.add_string(v->get_type()), db.add_string(v->get_id()), db.add_string(v->get_bases()),
+                db.add_string(v->get_dimensions()), db.add_string(v->get_cxx_type()), v->get_bits(),
+                db.get_location(v->decl_loc_), static_cast<uint32_t>(v->sea_locs_.size()) });
+            for (const auto &loc : v->sea_locs_)
+            {
+                db.add_record(db.get_location(loc));
+            }
+        }
+    }
+
+    LOG_INFO("Writing VRTL Analysis database: ", file.string());
+    return db.write(file, header);
+}
+
+bool VrtlmodCore::read_analysis_db(const fs::path &file)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(file.string(), /*IsText*/ false, /*RequiresNullTerminator*/ false);
+    if (!buffer)
+    {
+        LOG_ERROR("Could not open analysis database [", file.string(), "]: ", buffer.getError().message());
+        return false;
+    }
+
+    DBReader db(file, **buffer);
+    // the whole database is read and validated before anything is added to the context, a truncated or corrupt
+    // database (LOG_FATAL of DBReader) is reported as failure and leaves no partial modules behind
+    std::unique_ptr<types::Cell> top_cell{ nullptr };
+    std::vector<std::unique_ptr<types::Module>> modules;
+    std::vector<std::pair<IdPair, types::Variable *>> variables;
+    try
+    {
+        const auto *header = db.next<analysisdb::Header>();
+        if (std::memcmp(header->magic_, analysisdb::MAGIC, sizeof(header->magic_)) != 0 ||
+            header->format_version_ != analysisdb::FORMAT_VERSION)
+        {
+            LOG_ERROR("[", file.string(), "] is not a vrtlmod analysis database of format version ",
+                      std::to_string(analysisdb::FORMAT_VERSION));
+            return false;
+        }
+        db.read_string_table(*header);
+        if (db.get_string(header->version_) != VRTLMOD_VERSION)
+        {
+            LOG_ERROR("Analysis database [", file.string(), "] was written by vrtlmod ",
+                      db.get_string(header->version_), ", expected ", VRTLMOD_VERSION);
+            return false;
+        }
+
+        if (header->has_top_cell_)
+        {
+            const auto *c = db.next<analysisdb::Cell>();
+            top_cell = std::make_unique<types::Cell>(db.get_string(c->id_), db.get_string(c->type_));
+            db.set_decl_loc(*top_cell, c->decl_loc_);
+        }
+        for (uint32_t i = 0; i < header->module_count_; ++i)
+        {
+            const auto *m = db.next<analysisdb::Module>();
+            auto mod = std::make_unique<types::Module>(db.get_string(m->id_));
+            db.set_decl_loc(*mod, m->decl_loc_);
+
+            const auto *instances = db.next<uint32_t>(m->instance_count_);
+            for (uint32_t j = 0; j < m->instance_count_; ++j)
+            {
+                mod->add_instance(db.get_string(instances[j]));
+            }
+            const auto *cells = db.next<analysisdb::Cell>(m->cell_count_);
+            for (uint32_t j = 0; j < m->cell_count_; ++j)
+            {
+                auto cell = std::make_unique<types::Cell>(db.get_string(cells[j].id_),
+                                                          db.get_string(cells[j].type_), mod.get());
+                db.set_decl_loc(*cell, cells[j].decl_loc_);
+                mod->add_cell(std::move(cell));
+            }
+            for (uint32_t j = 0; j < m->variable_count_; ++j)
+            {
+                const auto *v = db.next<analysisdb::Variable>();
+                auto var = std::make_unique<types::Variable>(db.get_string(v->type_), db.get_string(v->id_),
+                                                             db.get_string(v->bases_), db.get_string(v->dim_),
+                                                             db.get_string(v->cxx_type_), v->bits_, *mod);
+                db.set_decl_loc(*var, v->decl_loc_);
+                const auto *locs = db.next<analysisdb::Location>(v->inj_loc_count_);
+                for (uint32_t k = 0; k < v->inj_loc_count_; ++k)
+                {
+                    var->add_inj_loc(db.get_string(locs[k].file_), locs[k].line_, locs[k].column_);
+                }
+                variables.emplace_back(IdPair{ mod->get_id(), var->get_id() }, var.get());
+                mod->add_variable(std::move(var));
+            }
+            modules.push_back(std::move(mod));
+        }
+    }
+    catch (const std::exception &)
+    {
+        LOG_ERROR("Could not restore VRTL analysis from [", file.string(), "]");
+        return false;
+    }
+
+    auto lock = lock_ctx();
+    if (top_cell)
+    {
+        ctx_->top_cell_ = std::move(top_cell);
+    }
+    ctx_->variable_index_.insert(variables.begin(), variables.end());
+    for (auto &mod : modules)
+    {
+        ctx_->module_index_.emplace(mod->get_id(), mod.get());
+        ctx_->modules_.insert(std::move(mod));
+    }
+    LOG_INFO("Restored ", std::to_string(modules.size()), " modules from VRTL Analysis database [",
+             file.string(), "]");
+    return true;
+}
+
+} // namespace vrtlmod
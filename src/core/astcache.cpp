@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file astcache.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/core/astcache.hpp"
+#include "vrtlmod/core/buildcache.hpp"
+#include "vrtlmod/util/logging.hpp"
+
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Serialization/PCHContainerOperations.h"
+
+namespace vrtlmod
+{
+
+ASTCache::ASTCache(const fs::path &dir) : dir_(dir), pch_ops_(std::make_shared<clang::PCHContainerOperations>())
+{
+    if (!fs::exists(dir_))
+    {
+        fs::create_directories(dir_);
+    }
+}
+
+ASTCache::~ASTCache(void) {}
+
+fs::path ASTCache::get_ast_path(const std::string &file) const
+{
+    // same-named files of different directories must not share an AST
+    auto path = fs::absolute(file).lexically_normal();
+    return dir_ / (path.filename().string() + "-" + BuildCache::hash(path.string()) + ".ast");
+}
+
+bool ASTCache::store(clang::ASTUnit &ast) const
+{
+    auto path = get_ast_path(ast.getMainFileName().str());
+    if (ast.Save(path.string()))
+    {
+        LOG_WARNING("Failed to cache AST of [", ast.getMainFileName().str(), "]");
+        return false;
+    }
+    LOG_VERBOSE("Cached AST of [", ast.getMainFileName().str(), "] in [", path.string(), "]");
+    return true;
+}
+
+std::unique_ptr<clang::ASTUnit> ASTCache::load(const std::string &file) const
+{
+    auto path = get_ast_path(file);
+    if (!fs::exists(path))
+    {
+        return nullptr;
+    }
+
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diags =
+        clang::CompilerInstance::createDiagnostics(new clang::DiagnosticOptions());
+    // validation of the AST's input files stays active, a stale AST fails to load
+    auto ast = clang::ASTUnit::LoadFromASTFile(path.string(), pch_ops_->getRawReader(), clang::ASTUnit::LoadEverything,
+                                               diags, clang::FileSystemOptions());
+    if (!ast)
+    {
+        LOG_WARNING("Failed to load cached AST of [", file, "] - re-parse");
+    }
+    return ast;
+}
+
+} // namespace vrtlmod
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file buildcache.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/core/buildcache.hpp"
+#include "vrtlmod/util/logging.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/SHA1.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace vrtlmod
+{
+
+BuildCache::BuildCache(const fs::path &dir) : dir_(dir)
+{
+    if (!fs::exists(dir_))
+    {
+        fs::create_directories(dir_);
+    }
+}
+
+std::string BuildCache::hash(const std::string &data)
+{
+    auto h = llvm::SHA1::hash(llvm::arrayRefFromStringRef(data));
+    return llvm::toHex(llvm::ArrayRef<uint8_t>(h), true);
+}
+
+std::string BuildCache::hash_file(const fs::path &file)
+{
+    std::ifstream in(file.string(), std::ios::binary);
+    if (!in.is_open())
+    {
+        return "";
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return hash(ss.str());
+}
+
+std::string BuildCache::get_file_key(const fs::path &file, const std::string &command) const
+{
+    return hash(util::concat(VRTLMOD_VERSION, ":", hash_file(file), ":", command));
+}
+
+fs::path BuildCache::get_entry_path(const std::string &key) const
+{
+    return dir_ / (key + ".clean");
+}
+
+bool BuildCache::is_up_to_date(const std::string &run_key) const
+{
+    std::ifstream in((dir_ / "run.key").string());
+    std::string last_key;
+    return (in >> last_key) && (last_key == run_key);
+}
+
+void BuildCache::set_up_to_date(const std::string &run_key) const
+{
+    // drop entries of files that are no longer part of the VRTL or have changed
+    for (const auto &it : fs::directory_iterator(dir_))
+    {
+        if (it.path().extension() == ".clean" && used_.find(it.path()) == used_.end())
+        {
+            fs::remove(it.path());
+        }
+    }
+    std::ofstream out((dir_ / "run.key").string());
+    out << run_key << std::endl;
+}
+
+void BuildCache::set_outdated(void) const
+{
+    boost::system::error_code ec;
+    fs::remove(dir_ / "run.key", ec);
+}
+
+bool BuildCache::restore_cleaned(const fs::path &file, const std::string &key) const
+{
+    auto entry = get_entry_path(key);
+    if (!fs::exists(entry))
+    {
+        return false;
+    }
+    fs::copy_file(entry, file, fs::copy_option::overwrite_if_exists);
+    {
+        std::lock_guard<std::mutex> lock(used_mutex_);
+        used_.insert(entry);
+    }
+    LOG_VERBOSE("Restored cleaned [", file.string(), "] from cache");
+    return true;
+}
+
+void BuildCache::store_cleaned(const fs::path &file, const std::string &key) const
+{
+    auto entry = get_entry_path(key);
+    fs::copy_file(file, entry, fs::copy_option::overwrite_if_exists);
+    std::lock_guard<std::mutex> lock(used_mutex_);
+    used_.insert(entry);
+}
+
+} // namespace vrtlmod
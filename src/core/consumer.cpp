@@ -63,7 +63,10 @@ bool Handler::inThisFile(clang::SourceLocation sl)
     return getRewriter().getSourceMgr().getFileID(sl) == getRewriter().getSourceMgr().getMainFileID();
 }
 
-Consumer::Consumer(clang::Rewriter &rw, const std::string &file) : fc_(rw, file) {}
+Consumer::Consumer(clang::Rewriter &rw, const std::string &file, bool scoped, std::set<std::string> vrtl_dirs)
+    : fc_(rw, file), scoped_(scoped), vrtl_dirs_(std::move(vrtl_dirs))
+{
+}
 
 void Consumer::ownHandler(std::unique_ptr<Handler> handler)
 {
@@ -73,10 +76,71 @@ void Consumer::ownHandler(std::unique_ptr<Handler> handler)
 
 void Consumer::Initialize(ASTContext &Context) {}
 
+std::vector<Decl *> Consumer::get_vrtl_scope(ASTContext &Context, const std::set<std::string> &vrtl_dirs)
+{
+    const SourceManager &sm = Context.getSourceManager();
+    const FileEntry *main_file = sm.getFileEntryForID(sm.getMainFileID());
+    if (main_file == nullptr)
+    {
+        return { Context.getTranslationUnitDecl() };
+    }
+
+    // directory entries hold the spelling of the include path, their (cached) canonical names are real paths
+    auto in_vrtl_dir = [&](const Decl *d)
+    {
+        const FileEntry *file = sm.getFileEntryForID(sm.getFileID(sm.getExpansionLoc(d->getLocation())));
+        if (file == nullptr)
+        {
+            return false;
+        }
+        if (vrtl_dirs.empty())
+        {
+            return (file->getDir() == main_file->getDir());
+        }
+        return (vrtl_dirs.count(sm.getFileManager().getCanonicalName(file->getDir()).str()) > 0);
+    };
+
+    std::vector<Decl *> scope;
+    for (Decl *d : Context.getTranslationUnitDecl()->decls())
+    {
+        const NamedDecl *nd = dyn_cast<NamedDecl>(d);
+        if ((nd == nullptr) || (nd->getIdentifier() == nullptr) || !in_vrtl_dir(d))
+        {
+            continue;
+        }
+        StringRef name = nd->getName();
+        if (isa<CXXRecordDecl>(d) && name.startswith("V"))
+        {
+            scope.push_back(d);
+        }
+        else if (isa<FunctionDecl>(d) &&
+                 (name.contains("_sequent__") || name.contains("_multiclk__") || name.contains("_eval")))
+        {
+            scope.push_back(d);
+        }
+    }
+    return scope;
+}
+
 void Consumer::HandleTranslationUnit(ASTContext &Context)
 {
     fc_.context_ = &Context;
-    matcher_.matchAST(Context);
+    if (scoped_)
+    {
+        auto scope = get_vrtl_scope(Context, vrtl_dirs_);
+        if (scope.empty())
+        {
+            LOG_WARNING("Scoped traversal found no VRTL declarations in ", fc_.file_);
+        }
+        LOG_VERBOSE("Traversing ", std::to_string(scope.size()), " VRTL declarations of ", fc_.file_);
+        Context.setTraversalScope(scope);
+        matcher_.matchAST(Context);
+        Context.setTraversalScope({ Context.getTranslationUnitDecl() });
+    }
+    else
+    {
+        matcher_.matchAST(Context);
+    }
     fc_.context_ = 0;
 }
 
@@ -20,6 +20,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "vrtlmod/core/core.hpp"
+#include "vrtlmod/core/filter.hpp"
 #include "vrtlmod/core/types.hpp"
 #include "vrtlmod/passes/pass.hpp"
 #include "vrtlmod/util/logging.hpp"
@@ -39,10 +40,16 @@
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/AST/TextNodeDumper.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 
 #include <pugixml.hpp>
 #include <regex>
 #include <algorithm>
+#include <exception>
+#include <mutex>
+#include <tuple>
 
 #include <boost/lexical_cast.hpp>
 
@@ -55,21 +62,6 @@ VrtlmodCore::VrtlmodCore(const char *out_dir_path, bool systemc)
     , ctx_(std::make_unique<Context>())
     , gen_(std::make_unique<vapi::VapiGenerator>(*this))
 {
-    // build up xml document
-    ctx_->xml_doc_ = std::make_unique<pugi::xml_document>();
-    auto root = ctx_->xml_doc_->append_child("vrtlmod_xml");
-    ctx_->xml_root_node_ = std::make_unique<pugi::xml_node>(root);
-    ctx_->xml_root_node_->append_attribute("version") = VRTLMOD_VERSION;
-
-    // ctx_->xml_root_node_ = std::make_unique<pugi::xml_node>(std::move(ctx_->xml_doc_->append_child("vrtlmod_xml")));
-    auto netlist = ctx_->xml_root_node_->append_child("top");
-    ctx_->xml_netlist_node_ = std::make_unique<pugi::xml_node>(netlist);
-
-    auto modules = ctx_->xml_root_node_->append_child("modules");
-    ctx_->xml_modules_node_ = std::make_unique<pugi::xml_node>(modules);
-
-    auto files = ctx_->xml_root_node_->append_child("files");
-    ctx_->xml_files_node_ = std::make_unique<pugi::xml_node>(files);
 }
 
 VrtlmodCore::~VrtlmodCore(void) {}
@@ -135,76 +127,159 @@ void clean_file(const std::string &file_path)
 {
     LOG_VERBOSE("> cleaning file", file_path);
 
-    std::ifstream in(file_path.c_str());
-    if (!in.is_open())
+    auto buffer = llvm::MemoryBuffer::getFile(file_path); // memory-maps large files
+    if (!buffer)
     {
         LOG_FATAL("Clean File could not open file path [", file_path, "]");
         return;
     }
-
-    std::stringstream ss;
-
-    while (in.good())
-    {
-        char c;
-        in.get(c);
-        ss << c;
-    }
-    in.close();
-
-    std::string data = ss.str();
-    ss.str("");
-    size_t pos = 0;
-    do
+    llvm::StringRef data = (*buffer)->getBuffer();
+
+    const llvm::StringRef public_comment = "/*verilator_public*/"; // TODO: what are these again?
+    const llvm::StringRef anon_struct = "struct {";                // TODO: what are these again?
+    const llvm::StringRef anon_struct_close = "};";
+
+    // single pass over all patterns, an anonymous struct's opening and its closing (the next "};") are removed
+    std::string out;
+    bool changed = false;
+    size_t copied = 0;         // data up to here is in out
+    unsigned open_structs = 0; // removed anonymous struct openings whose closing is pending
+    for (size_t pos = data.find_first_of("/s}"); pos != llvm::StringRef::npos; pos = data.find_first_of("/s}", pos))
     {
-        pos = data.find("/*verilator_public*/", pos); // TODO: what are these again?
-        if (pos != std::string::npos)
-            data.replace(pos, 20, "//verilator_public");
-
-    } while (pos != std::string::npos);
-    pos = 0;
-    do
-    {
-        pos = data.find("struct {", pos); // TODO: what are these again?
-        if (pos != std::string::npos)
+        llvm::StringRef rest = data.substr(pos);
+        llvm::StringRef replacement = "";
+        size_t len = 0;
+        if (rest.startswith(public_comment))
+        {
+            replacement = "//verilator_public";
+            len = public_comment.size();
+        }
+        else if (rest.startswith(anon_struct))
         {
             LOG_VERBOSE(">>> replace anonymous struct.");
-            data.replace(pos, 8, "");
-            auto closepos = data.find("};", pos);
-            data.replace(closepos, 2, "");
+            len = anon_struct.size();
+            ++open_structs;
+        }
+        else if (open_structs > 0 && rest.startswith(anon_struct_close))
+        {
+            len = anon_struct_close.size();
+            --open_structs;
         }
 
-    } while (pos != std::string::npos);
+        if (len == 0)
+        {
+            ++pos;
+            continue;
+        }
+        if (!changed)
+        {
+            out.reserve(data.size());
+            changed = true;
+        }
+        out.append(data.data() + copied, pos - copied);
+        out.append(replacement.data(), replacement.size());
+        pos += len;
+        copied = pos;
+    }
 
-    std::ofstream out(file_path.c_str());
-    if (!out.is_open())
+    if (open_structs > 0)
+    {
+        LOG_WARNING("Clean File did not find closing of ", std::to_string(open_structs), " anonymous struct(s) in [",
+                    file_path, "]");
+    }
+    if (!changed)
     {
-        LOG_FATAL("Clean File could not open file path [", file_path, "]");
         return;
     }
+    out.append(data.data() + copied, data.size() - copied);
+    buffer->reset(); // release mapping before overwriting the file
 
-    out << data;
-
-    out.flush();
-    out.close();
+    std::error_code ec;
+    llvm::raw_fd_ostream os(file_path, ec);
+    if (ec)
+    {
+        LOG_FATAL("Clean File could not open file path [", file_path, "]");
+        return;
+    }
+    os << out;
+    os.close();
+    if (os.has_error())
+    {
+        // a pending error would make the stream's destructor abort instead of throwing
+        ec = os.error();
+        os.clear_error();
+        LOG_FATAL("Clean File could not write file path [", file_path, "]: ", ec.message());
+    }
 }
 
 std::vector<std::string> VrtlmodCore::prepare_sources(const std::vector<std::string> &files, bool overwrite)
 {
     return prepare_files(files, { ".cpp", ".cc" }, overwrite);
 }
-std::vector<std::string> VrtlmodCore::prepare_headers(const std::vector<std::string> &files, bool overwrite)
+std::vector<std::string> VrtlmodCore::prepare_headers(const std::vector<std::string> &files, bool overwrite,
+                                                      unsigned jobs)
 {
     auto headers = prepare_files(files, { ".h", ".hpp" }, overwrite);
+    // headers are cleaned independently of each other. Failures (LOG_FATAL) of clean_file must not leave a pool
+    // thread, the first one is rethrown after all headers are done
+    std::mutex except_mutex;
+    std::exception_ptr except{ nullptr };
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
     for (const auto &it : headers)
     {
-        clean_file(it);
+        pool.async(
+            [&, it]()
+            {
+                try
+                {
+                    clean_file(it);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(except_mutex);
+                    if (!except)
+                    {
+                        except = std::current_exception();
+                    }
+                }
+            });
+    }
+    pool.wait();
+    if (except)
+    {
+        std::rethrow_exception(except);
     }
     gen_->build_targetdictionary(); // write the common target dictionary header to the output dir
 
     return headers;
 }
 
+void VrtlmodCore::set_vrtl_files(const std::vector<std::string> &files)
+{
+    // real paths, as the canonical directory names of the FileManager the Consumer compares against
+    vrtl_dirs_.clear();
+    for (const auto &it : files)
+    {
+        llvm::SmallString<256> dir;
+        if (llvm::sys::fs::real_path(fs::absolute(it).parent_path().string(), dir))
+        {
+            LOG_WARNING("VRTL directory of [", it, "] not found");
+            continue;
+        }
+        vrtl_dirs_.insert(dir.str().str());
+    }
+}
+
+std::string VrtlmodCore::get_include_string(void) const
+{
+    std::string ret = "#include \"targetdictionary.hpp\"\n";
+    if (td_instances_)
+    {
+        ret += util::concat("#include \"", gen_->get_td_instances_header_filename(), "\"\n");
+    }
+    return ret;
+}
+
 std::string VrtlmodCore::get_vrtltopheader_filename(void) const
 {
     std::string top_name = get_top_cell().get_type();
@@ -245,7 +320,6 @@ std::string VrtlmodCore::getTDExternalDecl(void) const
 
 int VrtlmodCore::is_decl_target(const clang::FieldDecl *target) const
 {
-    int ret = -1;
     std::string t_type = target->getType().getAsString();
     std::string t_name = target->getName().str();
     std::string t_a_type = target->getParent()->getTypeForDecl()->getTypeClassName();
@@ -254,53 +328,50 @@ int VrtlmodCore::is_decl_target(const clang::FieldDecl *target) const
     LOG_VERBOSE("t_a_name: ", t_a_name, " of type ", t_a_type);
     LOG_VERBOSE("t_name: ", t_name, " of type ", t_type);
 
-    bool found = false;
-    auto func = [&](const types::Target &it)
+    int ret = find_injection_target(t_a_name, t_name);
+    if (ret >= 0)
     {
-        ++ret;
-        std::string target_name = it.get_id();
-        std::string target_parent = types::Module(it.parent()).get_id();
+        LOG_VERBOSE(">>> same target:", t_name, " of type ", t_type);
+    }
+    return ret;
+}
 
-        LOG_VERBOSE(">> target:", target_name, " of parent ", target_parent, " of type ", it.parent().name());
-        if (t_a_name == target_parent)
-        {
-            LOG_VERBOSE(">>> same ancestor:", t_a_name, " of type ", t_a_type);
+types::Target &VrtlmodCore::get_target_from_index(int idx) const
+{
+    return *(ctx_->inj_target_registry_[idx]);
+}
 
-            if (t_name == target_name)
-            {
-                found = true;
-                LOG_VERBOSE(">>> same target:", t_name, " of type ", t_type);
-                return false;
-            }
-        }
-        return true;
-    };
-    foreach_injection_target(func);
+types::Module *VrtlmodCore::find_module(const std::string &module_id) const
+{
+    auto it = ctx_->module_index_.find(module_id);
+    return (it != ctx_->module_index_.end()) ? it->second : nullptr;
+}
 
-    return found ? ret : -1;
+types::Variable *VrtlmodCore::find_variable(const std::string &module_id, const std::string &var_id) const
+{
+    auto it = ctx_->variable_index_.find(IdPair{ module_id, var_id });
+    return (it != ctx_->variable_index_.end()) ? it->second : nullptr;
 }
 
-types::Target &VrtlmodCore::get_target_from_index(int idx) const
+int VrtlmodCore::find_injection_target(const std::string &module_id, const std::string &var_id) const
 {
-    return (**std::next(ctx_->toinj_targets_.begin(), idx));
+    auto it = ctx_->inj_target_index_.find(IdPair{ module_id, var_id });
+    return (it != ctx_->inj_target_index_.end()) ? it->second : -1;
 }
 
 const types::Module *VrtlmodCore::add_module(const clang::CXXRecordDecl *module, const clang::ASTContext &ctx) const
 {
+    auto lock = lock_ctx();
     std::string id = module->getNameAsString();
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter =
-        std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(), [id](const auto &it) { return id == it->get_id(); });
-    if (mod_iter == ctx_->modules_.end())
+    if (find_module(id) == nullptr)
     {
-        auto xml_node = ctx_->xml_modules_node_->append_child("module");
-        xml_node.append_attribute("id") = id.c_str();
-        auto mod_inst = std::make_unique<types::Module>(xml_node);
+        auto mod_inst = std::make_unique<types::Module>(id);
 
         mod_inst->add_decl_loc(LOCATABLE_INITIALIZER(module->getLocation(), ctx.getSourceManager()));
-        const types::Module *ret = mod_inst.get();
+        types::Module *ret = mod_inst.get();
 
         ctx_->modules_.insert(std::move(mod_inst));
+        ctx_->module_index_.emplace(id, ret);
         return ret;
     }
     else
@@ -314,15 +385,11 @@ const types::Module *VrtlmodCore::add_module_instance(const clang::NamedDecl *in
                                                       const clang::CXXRecordDecl *module,
                                                       const clang::ASTContext &ctx) const
 {
-    std::string id = module->getNameAsString();
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter =
-        std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(), [id](const auto &it) { return id == it->get_id(); });
-
-    if (mod_iter != ctx_->modules_.end())
+    auto lock = lock_ctx();
+    if (types::Module *mod = find_module(module->getNameAsString()))
     {
-        (*mod_iter)->add_instance(instance_decl->getNameAsString());
-        return (*mod_iter).get();
+        mod->add_instance(instance_decl->getNameAsString());
+        return mod;
     }
     return nullptr;
 }
@@ -336,7 +403,7 @@ const types::Module *VrtlmodCore::add_module_instance(const clang::MemberExpr *i
 
 const types::Cell *VrtlmodCore::add_cell(const clang::FieldDecl *cell, const clang::ASTContext &ctx) const
 {
-
+    auto lock = lock_ctx();
     std::string id = cell->getNameAsString();
     std::string cell_type = cell->getType().getAsString();
     util::strhelp::replaceAll(cell_type, "class ", "");
@@ -344,34 +411,27 @@ const types::Cell *VrtlmodCore::add_cell(const clang::FieldDecl *cell, const cla
     util::strhelp::replaceAll(cell_type, " ", "");
     std::string module_id = cell->getParent()->getName().str();
 
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter = std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(),
-                            [module_id](const auto &it) { return module_id == it->get_id(); });
-    if (mod_iter == ctx_->modules_.end())
+    types::Module *mod = find_module(module_id);
+    if (mod == nullptr)
     {
         LOG_VERBOSE("{cell}: [", id, "] of type [", cell_type, "] no matchting parent [", module_id, "] found");
         return nullptr;
     }
 
-    std::set<std::unique_ptr<types::Cell>>::iterator cell_iter;
-    cell_iter = std::find_if((*mod_iter)->cells_.begin(), (*mod_iter)->cells_.end(),
-                             [id](const auto &it) { return id == it->get_id(); });
-    if (cell_iter != (*mod_iter)->cells_.end())
+    auto cell_iter =
+        std::find_if(mod->cells_.begin(), mod->cells_.end(), [id](const auto &it) { return id == it->get_id(); });
+    if (cell_iter != mod->cells_.end())
     {
         LOG_VERBOSE("{cell}: [", id, "] of type [", cell_type, "]  already a member of parent [", module_id, "]");
         return nullptr;
     }
 
-    auto xml_node = (*mod_iter)->append_child("cell");
-    xml_node.append_attribute("id") = id.c_str();
-    xml_node.append_attribute("type") = cell_type.c_str();
-
-    auto cell_instance = std::make_unique<types::Cell>(xml_node); //, **mod_iter);
+    auto cell_instance = std::make_unique<types::Cell>(id, cell_type, mod);
 
     cell_instance->add_decl_loc(LOCATABLE_INITIALIZER(cell->getLocation(), ctx.getSourceManager()));
     const types::Cell *ret = cell_instance.get();
 
-    (*mod_iter)->add_cell(std::move(cell_instance));
+    mod->add_cell(std::move(cell_instance));
 
     return ret;
 }
@@ -379,6 +439,7 @@ const types::Cell *VrtlmodCore::add_cell(const clang::FieldDecl *cell, const cla
 const types::Variable *VrtlmodCore::add_variable(const clang::FieldDecl *variable, const clang::ASTContext &ctx,
                                                  const clang::Rewriter &rew) const
 {
+    auto lock = lock_ctx();
     auto &srcmgr = ctx.getSourceManager();
     auto &lang_opts = ctx.getLangOpts();
 
@@ -386,19 +447,14 @@ const types::Variable *VrtlmodCore::add_variable(const clang::FieldDecl *variabl
     std::string type = variable->getType().getAsString();
     std::string module_id = variable->getParent()->getName().str();
 
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter = std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(),
-                            [module_id](const auto &it) { return module_id == it->get_id(); });
-    if (mod_iter == ctx_->modules_.end())
+    types::Module *mod = find_module(module_id);
+    if (mod == nullptr)
     {
         LOG_VERBOSE("{variable}: [", id, "] of parent [", module_id, "] no matching parent module found.");
         return nullptr;
     }
 
-    std::set<std::unique_ptr<types::Variable>>::iterator var_iter;
-    var_iter = std::find_if((*mod_iter)->variables_.begin(), (*mod_iter)->variables_.end(),
-                            [id](const auto &it) { return id == it->get_id(); });
-    if (var_iter != (*mod_iter)->variables_.end())
+    if (find_variable(module_id, id) != nullptr)
     {
         LOG_VERBOSE("{variable}: [", id, "] of type [", type, "]  already a member of parent [", module_id, "]");
         return nullptr;
@@ -621,25 +677,20 @@ const types::Variable *VrtlmodCore::add_variable(const clang::FieldDecl *variabl
         return nullptr;
     }
 
-    auto xml_node = (*mod_iter)->append_child(var_type.c_str());
-    xml_node.append_attribute("id") = id.c_str();
-    xml_node.append_attribute("bases") = util::concat("[", bases, "]").c_str();
-    xml_node.append_attribute("dim") = util::concat("[", dim, "]").c_str();
-    xml_node.append_attribute("cxx_type") = type.c_str();
-    // xml_node.append_attribute("decl") = decl_source_code_text.c_str();
-    xml_node.append_attribute("bits") = bits;
-
-    auto var_inst = std::make_unique<types::Variable>(xml_node); //, **it);
+    auto var_inst = std::make_unique<types::Variable>(var_type, id, util::concat("[", bases, "]"),
+                                                      util::concat("[", dim, "]"), type, bits, *mod);
 
     var_inst->add_decl_loc(LOCATABLE_INITIALIZER(variable->getLocation(), ctx.getSourceManager()));
-    const types::Variable *ret = var_inst.get();
+    types::Variable *ret = var_inst.get();
 
-    (*mod_iter)->add_variable(std::move(var_inst));
+    mod->add_variable(std::move(var_inst));
+    ctx_->variable_index_.emplace(IdPair{ module_id, id }, ret);
     return ret;
 }
 
 const types::Cell *VrtlmodCore::set_top_cell(const clang::FieldDecl *cell, const clang::ASTContext &ctx) const
 {
+    auto lock = lock_ctx();
     std::string id = cell->getNameAsString();
     std::string cell_type = cell->getType().getAsString();
     util::strhelp::replaceAll(cell_type, "struct", "");
@@ -658,11 +709,7 @@ const types::Cell *VrtlmodCore::set_top_cell(const clang::FieldDecl *cell, const
     else
     {
         LOG_VERBOSE("{top cell}: Set top cell instance to [", id, "] of type [", cell_type, "]");
-        auto xml_node = ctx_->xml_netlist_node_->append_child("cell");
-        xml_node.append_attribute("id") = id.c_str();
-        xml_node.append_attribute("type") = cell_type.c_str();
-
-        ctx_->top_cell_ = std::make_unique<types::Cell>(xml_node);
+        ctx_->top_cell_ = std::make_unique<types::Cell>(id, cell_type);
 
         ctx_->top_cell_->add_decl_loc(LOCATABLE_INITIALIZER(cell->getLocation(), ctx.getSourceManager()));
 
@@ -673,105 +720,252 @@ const types::Cell *VrtlmodCore::set_top_cell(const clang::FieldDecl *cell, const
 int VrtlmodCore::is_expr_target(const clang::MemberExpr *assignee, const clang::CXXRecordDecl *parent,
                                 const clang::ASTContext &ctx) const
 {
-    int ret = -1;
-    bool found = false;
-
     std::string var_id = assignee->getMemberNameInfo().getAsString(); // assignee->getNameAsString();
     std::string var_type = assignee->getType().getAsString();
     std::string module_id = parent->getName().str();
     std::string module_type = parent->getTypeForDecl()->getTypeClassName();
 
     LOG_VERBOSE(">>>>> INJREW: {variable}: [", var_id, "] of parent [", module_id, "]");
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter = std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(),
-                            [module_id](const auto &it) { return module_id == it->get_id(); });
-    if (mod_iter == ctx_->modules_.end())
+    if (find_module(module_id) == nullptr)
     {
         LOG_WARNING(">>>>> INJREW: {variable}: [", var_id, "] of parent [", module_id, "] no matching module found.");
         return -1;
     }
 
-    std::set<std::unique_ptr<types::Variable>>::iterator var_iter;
-    var_iter = std::find_if((*mod_iter)->variables_.begin(), (*mod_iter)->variables_.end(),
-                            [var_id](const auto &it) { return var_id == it->get_id(); });
-    if (var_iter == (*mod_iter)->variables_.end())
+    const types::Variable *var = find_variable(module_id, var_id);
+    if (var == nullptr)
     {
         LOG_WARNING(">>>>> INJREW: {variable}: [", var_id, "] of parent [", module_id,
                     "] no matching variable found in module.");
         return -1;
     }
-    else
+    LOG_VERBOSE(">>>>> INJREW: {variable}: [", var->get_id(), "] of parent [", module_id,
+                "] found injection location at ", "<TODO>", " of ", std::to_string(var->sea_locs_.size()));
+
+    // targets are assigned here if declared in the record declaring the assigned member (see Target::is_assigned_here)
+    std::string decl_module_id =
+        static_cast<const clang::FieldDecl *>(assignee->getMemberDecl())->getParent()->getName().str();
+    int ret = find_injection_target(decl_module_id, var_id);
+    if (ret >= 0)
     {
-        LOG_VERBOSE(">>>>> INJREW: {variable}: [", (*var_iter)->get_id(), "] of parent [", module_id,
-                    "] found injection location at ", "<TODO>", " of set [", (*var_iter)->get_inj_loc(), "]");
-
-        auto func = [&](const types::Target &it)
-        {
-            ++ret;
-            if (it.is_assigned_here(assignee, parent))
-            {
-                found = true;
-                LOG_VERBOSE(">>>>> INJREW: target is assigned here", it.get_id(), " of type ", it.get_type(),
-                            " of parent ", types::Module(it.parent()).get_id());
-                return false;
-            }
-            return true;
-        };
-        foreach_injection_target(func);
+        LOG_VERBOSE(">>>>> INJREW: target is assigned here", var_id, " of parent ", decl_module_id);
     }
-
-    return found ? ret : -1;
+    return ret;
 }
 
 const types::Variable *VrtlmodCore::add_injection_location(const clang::MemberExpr *assignee,
                                                            const clang::CXXRecordDecl *parent,
                                                            const clang::ASTContext &ctx) const
 {
+    auto lock = lock_ctx();
     std::string var_id = assignee->getMemberNameInfo().getAsString(); // assignee->getNameAsString();
-    std::string var_type = assignee->getType().getAsString();
     std::string module_id = parent->getName().str();
-    std::string module_type = parent->getTypeForDecl()->getTypeClassName();
+
+    auto &srcmgr = ctx.getSourceManager();
+    auto loc = assignee->getExprLoc();
+    return add_injection_location(module_id, var_id, LOCATABLE_GET_FILENAME_FROM_CLANG(loc, srcmgr).str(),
+                                  LOCATABLE_GET_LINE_FROM_CLANG(loc, srcmgr), LOCATABLE_GET_COL_FROM_CLANG(loc, srcmgr),
+                                  ctx_->defer_inj_locs_);
+}
+
+const types::Variable *VrtlmodCore::add_injection_location(const std::string &module_id, const std::string &var_id,
+                                                           const std::string &file, int line, int column,
+                                                           bool defer) const
+{
+    auto lock = lock_ctx();
+    auto defer_location = [&]()
+    {
+        LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id, "] deferred until elaboration is complete.");
+        ctx_->deferred_inj_locs_.push_back({ module_id, var_id, file, line, column });
+    };
 
     LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id, "]");
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    mod_iter = std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(),
-                            [module_id](const auto &it) { return module_id == it->get_id(); });
-    if (mod_iter == ctx_->modules_.end())
+    if (find_module(module_id) == nullptr)
     {
-        LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id, "] no matching module found.");
+        if (defer)
+        {
+            defer_location();
+        }
+        else
+        {
+            LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id, "] no matching module found.");
+        }
         return nullptr;
     }
 
-    std::set<std::unique_ptr<types::Variable>>::iterator var_iter;
-    var_iter = std::find_if((*mod_iter)->variables_.begin(), (*mod_iter)->variables_.end(),
-                            [var_id](const auto &it) { return var_id == it->get_id(); });
-    if (var_iter == (*mod_iter)->variables_.end())
+    types::Variable *var = find_variable(module_id, var_id);
+    if (var == nullptr)
     {
-        LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id, "] no matching variable found in module.");
+        if (defer)
+        {
+            defer_location();
+        }
+        else
+        {
+            LOG_VERBOSE("{variable}: [", var_id, "] of parent [", module_id,
+                        "] no matching variable found in module.");
+        }
         return nullptr;
     }
     else
     {
-        if ((*var_iter)->get_type() == "in")
+        if (var->get_type() == "in")
         {
-            LOG_VERBOSE("{variable}: [", (*var_iter)->get_id(), "] of parent [", module_id,
-                        "] found injection location at[", (*var_iter)->get_inj_loc(), "] - skip variable is input!");
+            LOG_VERBOSE("{variable}: [", var->get_id(), "] of parent [", module_id,
+                        "] found injection location - skip variable is input!");
             return nullptr;
         }
-        LOG_VERBOSE("{variable}: [", (*var_iter)->get_id(), "] of parent [", module_id,
-                    "] found injection location at[", (*var_iter)->get_inj_loc(), "]");
-        (*var_iter)->add_inj_loc(LOCATABLE_INITIALIZER(assignee->getExprLoc(), ctx.getSourceManager()));
+        LOG_VERBOSE("{variable}: [", var->get_id(), "] of parent [", module_id, "] found injection location #",
+                    std::to_string(var->sea_locs_.size() + 1));
+        var->add_inj_loc(file, line, column);
+
+        return var;
+    }
+}
+
+void VrtlmodCore::defer_injection_locations(bool defer)
+{
+    auto lock = lock_ctx();
+    ctx_->defer_inj_locs_ = defer;
+}
+
+void VrtlmodCore::resolve_deferred_injection_locations(void)
+{
+    auto lock = lock_ctx();
+    auto deferred = std::move(ctx_->deferred_inj_locs_);
+    ctx_->deferred_inj_locs_.clear();
 
-        return var_iter->get();
+    LOG_VERBOSE("Resolving ", std::to_string(deferred.size()), " deferred injection locations.");
+    for (const auto &it : deferred)
+    {
+        if (const types::Variable *var =
+                add_injection_location(it.module_id_, it.variable_id_, it.file_, it.line_, it.column_, false))
+        {
+            LOG_INFO("injection location for [", var->get_id(), "] resolved after elaboration at: ", it.file_, ":l",
+                     std::to_string(it.line_), ":c", std::to_string(it.column_));
+        }
+    }
+}
+
+namespace
+{
+/// declaration order of locatables, i.e., by file, line and column
+bool is_declared_before(const types::Locatable *lhs, const types::Locatable *rhs)
+{
+    auto key = [](const types::Locatable *l)
+    {
+        const auto &loc = l->decl_loc_;
+        return loc ? std::make_tuple(loc->get_id(), loc->get_line(), loc->get_column())
+                   : std::make_tuple(std::string(), 0, 0);
+    };
+    return key(lhs) < key(rhs);
+}
+
+void append_locations(pugi::xml_node &node, const types::Locatable &l)
+{
+    if (l.decl_loc_)
+    {
+        node.append_attribute("decl_loc") = l.get_decl_loc().c_str();
+    }
+    if (l.has_inj_loc())
+    {
+        node.append_attribute("inj_loc") = l.get_inj_loc().c_str();
+    }
+}
+
+void append_cell(pugi::xml_node &parent, const types::Cell &c)
+{
+    auto node = parent.append_child("cell");
+    node.append_attribute("id") = c.get_id().c_str();
+    node.append_attribute("type") = c.get_type().c_str();
+    append_locations(node, c);
+}
+
+void append_variable(pugi::xml_node &parent, const types::Variable &v)
+{
+    auto node = parent.append_child(v.get_type().c_str());
+    node.append_attribute("id") = v.get_id().c_str();
+    node.append_attribute("bases") = v.get_bases().c_str();
+    node.append_attribute("dim") = v.get_dimensions().c_str();
+    node.append_attribute("cxx_type") = v.get_cxx_type().c_str();
+    node.append_attribute("bits") = v.get_bits();
+    append_locations(node, v);
+}
+} // namespace
+
+void VrtlmodCore::build_injectable_targets(void)
+{
+    for (const auto &m : ctx_->modules_)
+    {
+        for (const auto &v : m->variables_)
+        {
+            // inputs never get injection locations (see add_injection_location)
+            if (v->has_inj_loc())
+            {
+                add_injectable_target(std::make_shared<types::Target>(*v));
+            }
+        }
     }
 }
 
 void VrtlmodCore::build_xml()
 {
+    // file ids are written to the locations, make them independent of the order of (parallel) parse runs
+    FileLocator::sort_files();
+    build_injectable_targets();
+
+    pugi::xml_document doc;
+    auto root = doc.append_child("vrtlmod_xml");
+    root.append_attribute("version") = VRTLMOD_VERSION;
+
+    auto netlist = root.append_child("top");
+    if (ctx_->top_cell_)
+    {
+        append_cell(netlist, *ctx_->top_cell_);
+    }
+
+    auto modules = root.append_child("modules");
+    std::vector<const types::Module *> sorted_modules;
+    for (const auto &m : ctx_->modules_)
+    {
+        sorted_modules.push_back(m.get());
+    }
+    std::sort(sorted_modules.begin(), sorted_modules.end(),
+              [](const types::Module *lhs, const types::Module *rhs) { return lhs->get_id() < rhs->get_id(); });
+    for (const auto *m : sorted_modules)
+    {
+        auto module_node = modules.append_child("module");
+        module_node.append_attribute("id") = m->get_id().c_str();
+        append_locations(module_node, *m);
+
+        std::vector<const types::Locatable *> members;
+        for (const auto &c : m->cells_)
+        {
+            members.push_back(c.get());
+        }
+        for (const auto &v : m->variables_)
+        {
+            members.push_back(v.get());
+        }
+        std::sort(members.begin(), members.end(), is_declared_before);
+        for (const auto *l : members)
+        {
+            if (const auto *c = dynamic_cast<const types::Cell *>(l))
+            {
+                append_cell(module_node, *c);
+            }
+            else
+            {
+                append_variable(module_node, *static_cast<const types::Variable *>(l));
+            }
+        }
+    }
+
+    auto files = root.append_child("files");
     FileLocator::foreach_relevant_file(
         [&](const auto &it)
         {
-            pugi::xml_node file_node = ctx_->xml_files_node_->append_child("file");
+            pugi::xml_node file_node = files.append_child("file");
             file_node.append_attribute("id") = util::concat("f", std::to_string(it.first)).c_str();
             file_node.append_attribute("path") = it.second.string().c_str();
         });
@@ -786,89 +980,18 @@ void VrtlmodCore::build_xml()
     outfile += "-vrtlmod.xml";
 
     LOG_INFO("Writing VRTL Analysis XML: ", outfile.string());
-    ctx_->xml_doc_->save_file(outfile.string().c_str());
-
-    struct ListWalker : public pugi::xml_tree_walker
-    {
-        virtual bool for_each(pugi::xml_node &node) override
-        {
-            std::string name = node.name();
-            LOG_VERBOSE("node: ", name);
-            if (name == "")
-            {
-                return false;
-            }
-            else if ((name == "var") || (name == "out") || (name == "inout"))
-            {
-                std::string parent = node.parent().name();
-                if (parent == "module")
-                {
-                    auto locator = types::Locatable(node);
-                    if (locator.get_inj_loc() == "") //(node.attribute("inj_loc").value() == "")
-                    {
-                        // does not have an injection location. Pass.
-                        return true;
-                    }
-                    types::Module m{ node.parent() };
-
-                    const types::Module *unique_module{ nullptr };
-                    auto func = [&m, &unique_module](const types::Module &it) -> bool
-                    {
-                        if (m == it)
-                        {
-                            unique_module = &it;
-                            return false;
-                        }
-                        return true;
-                    };
-                    core_.foreach_module(func);
-
-                    if (unique_module != nullptr)
-                    {
-                        core_.add_injectable_target(std::make_shared<types::Target>(node, *unique_module));
-                    }
-                }
-            }
-            return true;
-        }
-        VrtlmodCore &core_;
-        ListWalker(VrtlmodCore &core) : core_(core) {}
-    } walker{ *this };
-    ctx_->xml_doc_->traverse(walker);
+    doc.save_file(outfile.string().c_str());
 }
 
-int VrtlmodCore::build_api(void)
+int VrtlmodCore::build_api(unsigned api_shards, unsigned jobs, bool compare_table)
 {
+    gen_->set_api_shards(api_shards);
+    gen_->set_jobs(jobs);
+    gen_->set_compare_table(compare_table);
     return gen_->build_api();
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \class Filter
-/// \brief Base class for filters generating injcetion targets for injectable targets
-struct Filter
-{
-    virtual std::set<const types::Target *> apply(const VrtlmodCore *core);
-
-    std::set<const types::Target *> targets_{};
-    Filter(void) {}
-    virtual ~Filter(void) {}
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \class WhiteListFilter
-/// \brief Filters injcetion targets for injectable targets by whitlist XML
-/// \details To use pass a VRTL analyze/elaborate XML file (VrtlmodCore::build_xml), with optionally deleted nodes
-struct WhiteListFilter : public Filter, public pugi::xml_tree_walker
-{
-    bool for_each(pugi::xml_node &node) override;
-    std::set<const types::Target *> apply(const VrtlmodCore *core) override;
-    const VrtlmodCore *core_{ nullptr };
-    fs::path fpath_;
-    WhiteListFilter(fs::path fpath) : fpath_(fpath) {}
-    virtual ~WhiteListFilter(void) {}
-};
-
-int VrtlmodCore::initialize_injection_targets(std::string file)
+int VrtlmodCore::initialize_injection_targets(std::string file, std::string rules_file)
 {
     std::unique_ptr<Filter> filter;
     // check for valid file
@@ -884,6 +1007,11 @@ int VrtlmodCore::initialize_injection_targets(std::string file)
         // we've got a whitelist file to filter our injectables with:
         filter = std::make_unique<WhiteListFilter>(fpath);
     }
+    if (rules_file != "")
+    {
+        // refine whitelisted (or all) injectables by selection rules
+        filter = std::make_unique<RuleFilter>(std::move(filter), fs::path(rules_file));
+    }
 
     apply_target_filter(std::move(filter));
 
@@ -893,20 +1021,11 @@ int VrtlmodCore::initialize_injection_targets(std::string file)
         LOG_INFO("\\->", t->_self());
     }
 
-    std::set<const types::Target *> removed{};
+    std::vector<const types::Target *> removed{};
     for (const auto &injectable : ctx_->injectable_targets_)
     {
-        bool rem = true;
-        for (const auto &injecting : ctx_->toinj_targets_)
-        {
-            if (injecting == injectable)
-            {
-                rem = false;
-                break;
-            }
-        }
-        if (rem)
-            removed.insert(injectable.get());
+        if (ctx_->toinj_targets_.count(injectable) == 0)
+            removed.push_back(injectable.get());
     }
 
     if (removed.size() > 0)
@@ -924,123 +1043,21 @@ int VrtlmodCore::initialize_injection_targets(std::string file)
 void VrtlmodCore::apply_target_filter(std::unique_ptr<Filter> filter) const
 {
     auto targets = filter->apply(this);
-    auto func = [&](const types::Target &it)
+    for (const auto &it : ctx_->injectable_targets_)
     {
-        for (const auto &v : targets)
+        if (targets.count(it.get()) > 0)
         {
-            types::Variable _v(static_cast<pugi::xml_node>(*v));
-            if (_v == it)
-            {
-                add_injection_target(it);
-                break; // target found can leave current it-eration
-            }
+            add_injection_target(it);
         }
-        return true; // continue loop thorugh injectables
-    };
-    foreach_injectable(func);
+    }
 }
 
 void VrtlmodCore::add_signal(std::shared_ptr<types::Target> sig) const
 {
+    auto lock = lock_ctx();
     ctx_->signals_.insert(sig);
 }
 
-void VrtlmodCore::set_top_cell(const pugi::xml_node &node) const
-{
-    ctx_->top_cell_ = std::make_unique<types::Cell>(node);
-}
-
-std::set<const types::Target *> Filter::apply(const VrtlmodCore *core)
-{
-    LOG_INFO("No Filter found. Making all injectables to injection targets.");
-    auto func = [&](const types::Target &t)
-    {
-        if (((t.get_name() == "out") || (t.get_name() == "inout")) && core->is_systemc())
-        {
-            const types::Module *top_module = core->get_module_from_cell(core->get_top_cell());
-            const types::Module &parent = t.get_parent();
-            if (parent == *top_module)
-            {
-                LOG_WARNING("Skip injection for SystemC Top-level Outputs: ", t._self());
-                return true; // FIXME: skip output ports of top-level systemc modules.
-                             // Currently no supported for injections
-            }
-        }
-        targets_.insert(&t);
-        LOG_VERBOSE(">> adding [", t._self(), "] to injection targets.");
-        return true;
-    };
-    core->foreach_injectable(func);
-
-    return targets_;
-}
-
-bool WhiteListFilter::for_each(pugi::xml_node &node)
-{
-    std::string name = node.name();
-    LOG_VERBOSE("> whitelist node: ", name);
-    if (name == "" || core_ == nullptr)
-    {
-        return false;
-    }
-    else if ((name == "var") || (name == "out") || (name == "inout"))
-    {
-        std::string parent = node.parent().name();
-
-        if (parent == "module")
-        {
-            if (((name == "out") || (name == "inout")) && core_->is_systemc())
-            {
-                const types::Module *top_module = core_->get_module_from_cell(core_->get_top_cell());
-                types::Module parent(node.parent());
-                if (parent == *top_module)
-                {
-                    types::Target t(node, parent);
-                    LOG_WARNING("Skip injection for SystemC Top-level Outputs: ", t._self());
-                    return true; // FIXME: skip output ports of top-level systemc modules.
-                                 // Currently no supported for injections
-                }
-            }
-
-            types::Variable v(node);
-            auto func = [&](const types::Target &t)
-            {
-                if (v == t)
-                {
-                    LOG_VERBOSE(">> adding [", t._self(), "] to injection targets.");
-                    targets_.insert(&t);
-                    return false;
-                }
-                return true;
-            };
-            core_->foreach_injectable(func);
-        }
-    }
-    return true;
-}
-
-std::set<const types::Target *> WhiteListFilter::apply(const VrtlmodCore *core)
-{
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(fpath_.c_str());
-    if (!result)
-    {
-        LOG_ERROR("XML [", fpath_.string(), "] parsed with errors, vrtlmod version: [",
-                  doc.child("vrtlmod_xml").attribute("version").value(), "]\n",
-                  "\tError description: ", result.description(), "\n",
-                  "\tError offset: ", std::to_string(result.offset), " (error at [...", fpath_.string(), ":",
-                  std::to_string(result.offset));
-    }
-    else
-    {
-        LOG_INFO("Filter found. Filtering injectables by whitelisting.");
-        core_ = core;
-        doc.traverse(*this);
-    }
-
-    return targets_;
-}
-
 void VrtlmodCore::foreach_signal(const std::function<bool(const types::Target &t)> &func) const
 {
     for (const auto &it : ctx_->signals_)
@@ -1092,56 +1109,45 @@ void VrtlmodCore::foreach_cell(const std::function<bool(const types::Cell &)> &f
 
 const types::Module *VrtlmodCore::get_module_from_cell(const types::Cell &c) const
 {
-    std::set<std::unique_ptr<types::Module>>::iterator mod_iter;
-    auto cell_type = c.get_type();
-    mod_iter = std::find_if(ctx_->modules_.begin(), ctx_->modules_.end(),
-                            [cell_type](const auto &it) { return cell_type == it->get_id(); });
-    if (mod_iter != ctx_->modules_.end())
-    {
-        return (*mod_iter).get();
-    }
-    return nullptr;
+    return find_module(c.get_type());
 }
 
-std::set<std::shared_ptr<types::Target>> &VrtlmodCore::get_signals(void) const
+VrtlmodCore::TargetSet &VrtlmodCore::get_signals(void) const
 {
     return (ctx_->signals_);
 }
 
-std::set<std::shared_ptr<types::Target>> &VrtlmodCore::get_inj_targets(void) const
+VrtlmodCore::TargetSet &VrtlmodCore::get_inj_targets(void) const
 {
     return (ctx_->toinj_targets_);
 }
 
-std::set<std::shared_ptr<types::Target>> &VrtlmodCore::get_injectable_targets(void) const
+VrtlmodCore::TargetSet &VrtlmodCore::get_injectable_targets(void) const
 {
     return (ctx_->injectable_targets_);
 }
 
 void VrtlmodCore::add_parsed_file(fs::path fpath) const
 {
+    auto lock = lock_ctx();
     ctx_->parsed_files_.insert(fpath);
 }
 
 void VrtlmodCore::add_injectable_target(std::shared_ptr<types::Target> t) const
 {
+    auto lock = lock_ctx();
     ctx_->injectable_targets_.insert(t);
 }
 
 void VrtlmodCore::add_injection_target(std::shared_ptr<types::Target> t) const
 {
-    ctx_->toinj_targets_.insert(t);
-}
-
-void VrtlmodCore::add_injection_target(const types::Target &t) const
-{
-    for (auto &tptr : get_injectable_targets())
+    auto lock = lock_ctx();
+    if (ctx_->toinj_targets_.insert(t).second)
     {
-        if (*tptr == t)
-        {
-            add_injection_target(tptr);
-            break;
-        }
+        // dense and stable index, i.e., position in the registry
+        t->index_ = ctx_->inj_target_registry_.size();
+        ctx_->inj_target_registry_.push_back(t);
+        ctx_->inj_target_index_.emplace(IdPair{ t->get_parent().get_id(), t->get_id() }, t->index_);
     }
 }
 
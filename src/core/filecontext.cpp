@@ -22,6 +22,9 @@
 #include "vrtlmod/core/filecontext.hpp"
 #include "vrtlmod/util/logging.hpp"
 
+#include <algorithm>
+#include <numeric>
+
 namespace vrtlmod
 {
 
@@ -51,32 +54,64 @@ bool FileContext::fatalFailure()
     return fatalFailure_;
 }
 
-std::map<int, fs::path> FileLocator::file_map_;
+std::unordered_map<std::string, int> FileLocator::file_ids_;
+std::deque<fs::path> FileLocator::files_;
+std::vector<int> FileLocator::sorted_ids_;
+std::shared_mutex FileLocator::files_mutex_;
 
 void FileLocator::foreach_relevant_file(const std::function<void(const std::pair<int, fs::path> &t)> &func)
 {
-    for (auto const &it : FileLocator::file_map_)
-        func(it);
+    std::shared_lock<std::shared_mutex> lock(files_mutex_);
+    std::vector<const fs::path *> by_public_id(files_.size());
+    for (size_t id = 0; id < files_.size(); ++id)
+        by_public_id[id < sorted_ids_.size() ? sorted_ids_[id] : id] = &files_[id];
+    for (size_t id = 0; id < by_public_id.size(); ++id)
+        func({ static_cast<int>(id), *by_public_id[id] });
+}
+
+void FileLocator::sort_files(void)
+{
+    std::unique_lock<std::shared_mutex> lock(files_mutex_);
+    std::vector<int> ids(files_.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::sort(ids.begin(), ids.end(), [](int lhs, int rhs) { return files_[lhs] < files_[rhs]; });
+    sorted_ids_.assign(files_.size(), 0);
+    for (size_t i = 0; i < ids.size(); ++i)
+        sorted_ids_[ids[i]] = static_cast<int>(i);
+}
+
+std::string FileLocator::get_id() const
+{
+    std::shared_lock<std::shared_mutex> lock(files_mutex_);
+    std::string ret = "f";
+    ret += std::to_string(static_cast<size_t>(id_) < sorted_ids_.size() ? sorted_ids_[id_] : id_);
+    return ret;
 }
 
-FileLocator::FileLocator(fs::path fpath, int line, int column) : line_(line), column_(column)
+int FileLocator::intern(const fs::path &fpath)
 {
-    bool found = false;
-    id_ = -1;
-    for (const auto &it : file_map_)
+    const auto &key = fpath.string();
     {
-        id_ = it.first;
-        if (it.second == fpath)
-        {
-            found = true;
-            break;
-        }
+        // fast path, all but the first location of a file
+        std::shared_lock<std::shared_mutex> lock(files_mutex_);
+        auto it = file_ids_.find(key);
+        if (it != file_ids_.end())
+            return it->second;
     }
-    if (!found)
+    std::unique_lock<std::shared_mutex> lock(files_mutex_);
+    auto it = file_ids_.emplace(key, static_cast<int>(files_.size()));
+    if (it.second)
     {
-        file_map_[++id_] = fpath;
+        files_.push_back(fpath);
+        LOG_VERBOSE("file: [f", std::to_string(it.first->second), "]", key);
     }
-    LOG_VERBOSE("file: [", get_id(), "]", fpath.string());
+    return it.first->second;
+}
+
+const fs::path &FileLocator::get_path() const
+{
+    std::shared_lock<std::shared_mutex> lock(files_mutex_);
+    return files_[id_];
 }
 
 } // namespace vrtlmod
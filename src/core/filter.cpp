@@ -0,0 +1,352 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file filter.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/core/filter.hpp"
+#include "vrtlmod/core/core.hpp"
+#include "vrtlmod/core/types.hpp"
+#include "vrtlmod/util/logging.hpp"
+
+#include "llvm/Support/Error.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace vrtlmod
+{
+
+namespace
+{
+/// compares a variable node of a VRTL analysis XML (see VrtlmodCore::build_xml) with a variable
+bool is_same_variable(const pugi::xml_node &node, const types::Variable &v)
+{
+    return (v.get_type() == node.name()) && (v.get_id() == node.attribute("id").value()) &&
+           (v.get_decl_loc() == node.attribute("decl_loc").value()) &&
+           (v.has_inj_loc() == !std::string(node.attribute("inj_loc").value()).empty()) &&
+           (v.get_bits() == node.attribute("bits").as_int()) && (v.get_bases() == node.attribute("bases").value()) &&
+           (v.get_dimensions() == node.attribute("dim").value()) &&
+           (v.get_cxx_type() == node.attribute("cxx_type").value());
+}
+} // namespace
+
+bool Filter::is_systemc_top_output(const VrtlmodCore &core, const types::Target &t)
+{
+    if (((t.get_type() == "out") || (t.get_type() == "inout")) && core.is_systemc())
+    {
+        const types::Module *top_module = core.get_module_from_cell(core.get_top_cell());
+        return (top_module != nullptr) && (t.get_parent() == *top_module);
+    }
+    return false;
+}
+
+std::unordered_set<const types::Target *> Filter::apply(const VrtlmodCore *core)
+{
+    LOG_INFO("No Filter found. Making all injectables to injection targets.");
+    auto func = [&](const types::Target &t)
+    {
+        if (is_systemc_top_output(*core, t))
+        {
+            LOG_WARNING("Skip injection for SystemC Top-level Outputs: ", t._self());
+            return true; // FIXME: skip output ports of top-level systemc modules.
+                         // Currently no supported for injections
+        }
+        targets_.insert(&t);
+        LOG_VERBOSE(">> adding [", t._self(), "] to injection targets.");
+        return true;
+    };
+    core->foreach_injectable(func);
+
+    return targets_;
+}
+
+bool WhiteListFilter::for_each(pugi::xml_node &node)
+{
+    std::string name = node.name();
+    LOG_VERBOSE("> whitelist node: ", name);
+    if (name == "" || core_ == nullptr)
+    {
+        return false;
+    }
+    else if ((name == "var") || (name == "out") || (name == "inout"))
+    {
+        std::string parent = node.parent().name();
+
+        if (parent == "module")
+        {
+            std::string module_id = node.parent().attribute("id").value();
+            auto it = index_.find(VrtlmodCore::IdPair{ module_id, node.attribute("id").value() });
+            if (it == index_.end() || !is_same_variable(node, *it->second))
+            {
+                return true; // not injectable or stale whitelist entry
+            }
+            const types::Target &t = *it->second;
+            if (is_systemc_top_output(*core_, t))
+            {
+                LOG_WARNING("Skip injection for SystemC Top-level Outputs: ", module_id,
+                            "::", node.attribute("id").value());
+                return true; // FIXME: skip output ports of top-level systemc modules.
+                             // Currently no supported for injections
+            }
+            LOG_VERBOSE(">> adding [", t._self(), "] to injection targets.");
+            targets_.insert(&t);
+        }
+    }
+    return true;
+}
+
+std::unordered_set<const types::Target *> WhiteListFilter::apply(const VrtlmodCore *core)
+{
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_file(fpath_.c_str());
+    if (!result)
+    {
+        LOG_ERROR("XML [", fpath_.string(), "] parsed with errors, vrtlmod version: [",
+                  doc.child("vrtlmod_xml").attribute("version").value(), "]\n",
+                  "\tError description: ", result.description(), "\n",
+                  "\tError offset: ", std::to_string(result.offset), " (error at [...", fpath_.string(), ":",
+                  std::to_string(result.offset));
+    }
+    else
+    {
+        LOG_INFO("Filter found. Filtering injectables by whitelisting.");
+        core_ = core;
+        core->foreach_injectable(
+            [&](const types::Target &t)
+            {
+                index_.emplace(VrtlmodCore::IdPair{ t.get_parent().get_id(), t.get_id() }, &t);
+                return true;
+            });
+        doc.traverse(*this);
+        index_.clear();
+    }
+
+    return targets_;
+}
+
+bool RuleFilter::Condition::match(const std::string &value) const
+{
+    if (op_ == Op::GLOB)
+    {
+        return glob_->match(value);
+    }
+    return std::regex_match(value, *regex_);
+}
+
+bool RuleFilter::Condition::match(const VrtlmodCore &core, const types::Target &t) const
+{
+    switch (field_)
+    {
+    case Field::HIER:
+    {
+        if (&t.get_parent() == core.get_module_from_cell(core.get_top_cell()) &&
+            match(util::concat(core.get_top_cell().get_id(), ".", t.get_id())))
+        {
+            return true;
+        }
+        for (const auto &instance : t.get_parent().symboltable_instances_)
+        {
+            if (match(util::concat(instance, ".", t.get_id())))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    case Field::MODULE:
+        return match(t.get_parent().get_id());
+    case Field::NAME:
+        return match(t.get_id());
+    case Field::TYPE:
+        return match(t.get_type());
+    case Field::CLASS:
+        return match(t.get_class());
+    case Field::BITS:
+        switch (op_)
+        {
+        case Op::EQ:
+            return t.get_bits() == bits_;
+        case Op::LT:
+            return t.get_bits() < bits_;
+        case Op::LE:
+            return t.get_bits() <= bits_;
+        case Op::GT:
+            return t.get_bits() > bits_;
+        case Op::GE:
+            return t.get_bits() >= bits_;
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+bool RuleFilter::Rule::match(const VrtlmodCore &core, const types::Target &t) const
+{
+    for (const auto &c : conditions_)
+    {
+        if (!c.match(core, t))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RuleFilter::parse(void)
+{
+    std::ifstream in(fpath_.string());
+    if (!in.is_open())
+    {
+        LOG_FATAL("Could not open target rules [", fpath_.string(), "]");
+    }
+
+    static const std::unordered_map<std::string, Condition::Field> fields = {
+        { "hier", Condition::Field::HIER },   { "module", Condition::Field::MODULE },
+        { "name", Condition::Field::NAME },   { "type", Condition::Field::TYPE },
+        { "class", Condition::Field::CLASS }, { "bits", Condition::Field::BITS }
+    };
+    static const std::unordered_map<std::string, Condition::Op> ops = {
+        { "=", Condition::Op::GLOB }, { "~", Condition::Op::REGEX }, { "<", Condition::Op::LT },
+        { "<=", Condition::Op::LE },  { ">", Condition::Op::GT },    { ">=", Condition::Op::GE }
+    };
+
+    std::string line;
+    for (int lineno = 1; std::getline(in, line); ++lineno)
+    {
+        auto where = util::concat(fpath_.string(), ":", std::to_string(lineno));
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        std::string token;
+        if (!(tokens >> token))
+        {
+            continue; // blank or comment
+        }
+        if (token != "include" && token != "exclude")
+        {
+            LOG_FATAL(where, ": expected `include` or `exclude`, got `", token, "`");
+        }
+        Rule rule{ token == "include", {} };
+
+        while (tokens >> token)
+        {
+            auto op_begin = token.find_first_of("=~<>");
+            auto op_end = token.find_first_not_of("=~<>", op_begin);
+            if (op_begin == std::string::npos || op_begin == 0 || op_end == std::string::npos)
+            {
+                LOG_FATAL(where, ": expected `<field><op><value>`, got `", token, "`");
+            }
+            auto field = fields.find(token.substr(0, op_begin));
+            if (field == fields.end())
+            {
+                LOG_FATAL(where, ": unknown field `", token.substr(0, op_begin), "`");
+            }
+            auto op = ops.find(token.substr(op_begin, op_end - op_begin));
+            if (op == ops.end())
+            {
+                LOG_FATAL(where, ": unknown operator `", token.substr(op_begin, op_end - op_begin), "`");
+            }
+            std::string value = token.substr(op_end);
+
+            Condition c{ field->second, op->second };
+            if (c.field_ == Condition::Field::BITS)
+            {
+                if (c.op_ == Condition::Op::REGEX)
+                {
+                    LOG_FATAL(where, ": `bits` takes one of `=`, `<`, `<=`, `>`, `>=`");
+                }
+                if (c.op_ == Condition::Op::GLOB)
+                {
+                    c.op_ = Condition::Op::EQ;
+                }
+                try
+                {
+                    c.bits_ = std::stoi(value);
+                }
+                catch (const std::exception &)
+                {
+                    LOG_FATAL(where, ": `bits` expects a number, got `", value, "`");
+                }
+            }
+            else if (c.op_ == Condition::Op::GLOB)
+            {
+                auto glob = llvm::GlobPattern::create(value);
+                if (!glob)
+                {
+                    LOG_FATAL(where, ": invalid glob `", value, "`: ", llvm::toString(glob.takeError()));
+                }
+                c.glob_ = std::move(*glob);
+            }
+            else if (c.op_ == Condition::Op::REGEX)
+            {
+                try
+                {
+                    c.regex_ = std::regex(value);
+                }
+                catch (const std::regex_error &e)
+                {
+                    LOG_FATAL(where, ": invalid regex `", value, "`: ", e.what());
+                }
+            }
+            else
+            {
+                LOG_FATAL(where, ": `", token.substr(0, op_begin), "` takes `=` (glob) or `~` (regex)");
+            }
+            rule.conditions_.push_back(std::move(c));
+        }
+        rules_.push_back(std::move(rule));
+    }
+}
+
+std::unordered_set<const types::Target *> RuleFilter::apply(const VrtlmodCore *core)
+{
+    parse();
+    targets_ = base_->apply(core);
+    LOG_INFO("Target rules found. Applying ", std::to_string(rules_.size()), " rules of [", fpath_.string(),
+             "] to injection targets.");
+
+    auto func = [&](const types::Target &t)
+    {
+        bool selected = targets_.count(&t) > 0;
+        for (const auto &rule : rules_)
+        {
+            if (rule.include_ != selected && rule.match(*core, t))
+            {
+                selected = rule.include_;
+            }
+        }
+        // rules are applied in order, last match wins, unsupported targets can not be included
+        if (selected && !is_systemc_top_output(*core, t))
+        {
+            if (targets_.insert(&t).second)
+            {
+                LOG_VERBOSE(">> including [", t._self(), "] to injection targets.");
+            }
+        }
+        else if (targets_.erase(&t) > 0)
+        {
+            LOG_VERBOSE(">> excluding [", t._self(), "] from injection targets.");
+        }
+        return true;
+    };
+    core->foreach_injectable(func);
+
+    return targets_;
+}
+
+} // namespace vrtlmod
@@ -43,10 +43,39 @@ std::string Target::get_hierarchyDedotted(void) const
     return get_id();
 }
 
+std::string Target::get_td_type(void) const
+{
+    const auto &layout = get_layout();
+    const auto &cxxdim = layout.cxx_dim_lengths_;
+    const auto &cxxdimtypes = layout.cxx_dim_types_;
+
+    std::stringstream x;
+    switch (cxxdim.size())
+    {
+    case 0:
+        x << "ZeroD_TDentry<" << get_cxx_type() << ">";
+        break;
+    case 1:
+        x << "OneD_TDentry<" << get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ">";
+        break;
+    case 2:
+        x << "TwoD_TDentry<" << get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ", " << cxxdim[1]
+          << ">";
+        break;
+    case 3:
+        x << "ThreeD_TDentry<" << get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ", "
+          << cxxdim[1] << ", " << cxxdim[2] << ">";
+        break;
+    default:
+        break;
+    }
+    return x.str();
+}
+
 std::string Target::_self(void) const
 {
-    return util::concat(get_class(), " ", types::Module(parent()).get_id(), "::", get_id(), "[",
-                        std::to_string(get_bits()), "] ", get_cxx_type());
+    return util::concat(get_class(), " ", get_parent().get_id(), "::", get_id(), "[", std::to_string(get_bits()),
+                        "] ", get_cxx_type());
 }
 
 bool Target::is_declared_here(const clang::FieldDecl *decl) const
@@ -56,10 +85,9 @@ bool Target::is_declared_here(const clang::FieldDecl *decl) const
     LOG_VERBOSE("Target::is_declared_here: ", get_id(), " == ", decl_name, "?");
     if (get_id() == decl_name)
     {
-        if (types::Module(parent()).get_id() == decl_ancestor_name)
+        if (get_parent().get_id() == decl_ancestor_name)
         {
-            LOG_VERBOSE("Target::is_declared_here: ", types::Module(parent()).get_id(), " == ", decl_ancestor_name,
-                        "?");
+            LOG_VERBOSE("Target::is_declared_here: ", get_parent().get_id(), " == ", decl_ancestor_name, "?");
             return true;
         }
     }
@@ -74,7 +102,7 @@ bool Target::is_assigned_here(const clang::MemberExpr *assignee, const clang::CX
 
     if (get_id() == decl_name)
     {
-        if (types::Module(pugi::xml_node::parent()).get_id() == decl_ancestor_name)
+        if (get_parent().get_id() == decl_ancestor_name)
         {
             return true;
         }
@@ -99,162 +127,132 @@ bool Target::check_assigned_here(const clang::MemberExpr *assignee, const clang:
     return ret;
 }
 
-std::vector<std::string> Target::get_cxx_dimension_types(void) const
-{
-    return get_cxx_dimensions().first;
-}
-
-std::vector<int> Target::get_cxx_dimension_lengths(void) const
+namespace
 {
-    return get_cxx_dimensions().second;
-}
-
-inline std::pair<int, int> Target::get_element_msb_lsb_pair(void) const
+/// splits a python-style list attribute, e.g., "['3:0', '7']", into its unquoted elements
+std::vector<std::string> split_list_attribute(std::string str)
 {
-    int msb = -1, lsb = -1;
-    std::string s, dimstr = get_dimensions();
-    auto brOpen = dimstr.find('[');
-    auto brClose = dimstr.rfind(']');
-    dimstr = dimstr.substr(brOpen + 1, brClose - brOpen - 1);
-    dimstr.erase(remove_if(dimstr.begin(), dimstr.end(), isspace), dimstr.end());
-    std::istringstream x(dimstr);
+    std::vector<std::string> ret{};
+    std::string s;
+    auto brOpen = str.find('[');
+    auto brClose = str.rfind(']');
+    str = str.substr(brOpen + 1, brClose - brOpen - 1);
+    str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
+    std::istringstream x(str);
     while (getline(x, s, ','))
     {
-        s = s.substr(s.find("'") + 1, s.rfind("'") - s.find("'") - 1);
-        if (s.find(':') != std::string::npos)
-        {
-            std::string up = s.substr(0, s.find(':'));
-            std::string to = s.substr(s.find(':') + 1);
-            msb = boost::lexical_cast<int>(up);
-            lsb = boost::lexical_cast<int>(to);
-            break;
-        }
+        ret.push_back(s.substr(s.find("'") + 1, s.rfind("'") - s.find("'") - 1));
     }
-    return { msb, lsb };
+    return ret;
 }
+} // namespace
 
-inline std::vector<int> Target::get_dimension_lengths(void) const
+TargetLayout::TargetLayout(const std::string &dim, const std::string &bases, int bits) : bits_(bits)
 {
-    std::vector<int> dim{};
-    std::string s, dimstr = get_dimensions();
-    auto brOpen = dimstr.find('[');
-    auto brClose = dimstr.rfind(']');
-    dimstr = dimstr.substr(brOpen + 1, brClose - brOpen - 1);
-    dimstr.erase(remove_if(dimstr.begin(), dimstr.end(), isspace), dimstr.end());
-    std::istringstream x(dimstr);
-    while (getline(x, s, ','))
+    for (const auto &s : split_list_attribute(dim))
     {
-        s = s.substr(s.find("'") + 1, s.rfind("'") - s.find("'") - 1);
-        if (s.find(':') == std::string::npos)
-            dim.push_back(boost::lexical_cast<int>(s));
+        auto colon = s.find(':');
+        if (colon == std::string::npos)
+        {
+            cxx_dim_lengths_.push_back(boost::lexical_cast<int>(s));
+        }
         else
         {
-            std::string up = s.substr(0, s.find(':'));
-            std::string to = s.substr(s.find(':') + 1);
-            int iup = boost::lexical_cast<int>(up);
-            int ito = boost::lexical_cast<int>(to);
-            dim.push_back(iup - ito + 1);
+            int iup = boost::lexical_cast<int>(s.substr(0, colon));
+            int ito = boost::lexical_cast<int>(s.substr(colon + 1));
+            if (msb_ < 0 && lsb_ < 0)
+            {
+                msb_ = iup;
+                lsb_ = ito;
+            }
+            cxx_dim_lengths_.push_back(iup - ito + 1);
         }
     }
-    return dim;
-}
-
-inline std::pair<std::vector<std::string>, std::vector<int>> Target::get_cxx_dimensions(void) const
-{
-    std::pair<std::vector<std::string>, std::vector<int>> dim{};
-    auto &cxxtypedim = dim.first;
-    auto &cxxdim = dim.second;
-    cxxdim = get_dimension_lengths();
-
-    std::string s, basetypestr = get_bases();
+    if (cxx_dim_lengths_.empty())
+    {
+        LOG_FATAL("Target layout, no dimensions in ", dim);
+    }
+    one_dim_bits_ = cxx_dim_lengths_.back();
 
-    auto brOpen = basetypestr.find('[');
-    auto brClose = basetypestr.rfind(']');
-    basetypestr = basetypestr.substr(brOpen + 1, brClose - brOpen - 1);
-    basetypestr.erase(remove_if(basetypestr.begin(), basetypestr.end(), isspace), basetypestr.end());
-    std::istringstream basetypestream(basetypestr);
-    while (getline(basetypestream, s, ','))
+    cxx_dim_types_ = split_list_attribute(bases);
+    if (cxx_dim_types_.empty())
     {
-        s = s.substr(s.find("'") + 1, s.rfind("'") - s.find("'") - 1);
-        cxxtypedim.push_back(s);
+        LOG_FATAL("Target layout, no base types in ", bases);
     }
 
-    if (cxxtypedim.back().find("VlWide<") != std::string::npos)
+    const auto &basetype = cxx_dim_types_.back();
+    if (basetype.find("VlWide<") != std::string::npos)
     {
-        auto dimstr = cxxtypedim.back();
-        brOpen = dimstr.find('<');
-        brClose = dimstr.rfind('>');
-        dimstr = dimstr.substr(brOpen + 1, brClose - brOpen - 1);
-        cxxdim.back() = boost::lexical_cast<int>(dimstr);
-        cxxtypedim.push_back("EData");
+        auto brOpen = basetype.find('<');
+        auto brClose = basetype.rfind('>');
+        cxx_dim_lengths_.back() = boost::lexical_cast<int>(basetype.substr(brOpen + 1, brClose - brOpen - 1));
+        cxx_dim_types_.push_back("EData");
     }
-    else if (cxxtypedim.back().find("WData[") != std::string::npos)
+    else if (basetype.find("WData[") != std::string::npos)
     {
-        auto dimstr = cxxtypedim.back();
-        brOpen = dimstr.find('[');
-        brClose = dimstr.rfind(']');
-        dimstr = dimstr.substr(brOpen + 1, brClose - brOpen - 1);
-        cxxdim.back() = boost::lexical_cast<int>(dimstr);
-        cxxtypedim.push_back("EData");
+        auto brOpen = basetype.find('[');
+        auto brClose = basetype.rfind(']');
+        cxx_dim_lengths_.back() = boost::lexical_cast<int>(basetype.substr(brOpen + 1, brClose - brOpen - 1));
+        cxx_dim_types_.push_back("EData");
     }
     else
-    { // remove last cxxdim_ element (numberof1dimbits)
-        cxxdim.pop_back();
+    { // remove last cxx_dim_lengths_ element (numberof1dimbits)
+        cxx_dim_lengths_.pop_back();
+    }
+
+    cxx_dim_strides_.resize(cxx_dim_lengths_.size());
+    for (size_t i = cxx_dim_lengths_.size(); i-- > 0;)
+    {
+        cxx_dim_strides_[i] = element_count_;
+        element_count_ *= cxx_dim_lengths_[i];
     }
 
-    return dim;
+    wide_ = one_dim_bits_ > static_cast<int>(sizeof(QData) * 8);
+    if (wide_)
+    {
+        const int word_bits = sizeof(WData) * 8;
+        words_ = (one_dim_bits_ + word_bits - 1) / word_bits;
+        element_mask_ = WData(-1);
+        auto active_bits = one_dim_bits_ % word_bits;
+        // fully used last element, i.e., no inactive rest
+        last_word_mask_ = (active_bits == 0) ? element_mask_ : ((1UL << active_bits) - 1);
+    }
+    else
+    {
+        // unpacked
+        for (int i = lsb_; i < msb_ + 1; ++i)
+        {
+            element_mask_ |= 1UL << i;
+        }
+        last_word_mask_ = element_mask_;
+    }
 }
 
-unsigned long Target::get_element_mask(std::initializer_list<size_t> subscripts) const
+unsigned long TargetLayout::get_element_mask(std::initializer_list<size_t> subscripts) const
 {
-    unsigned long mask = 0;
-    auto dimlens = get_cxx_dimension_lengths();
-
-    if (subscripts.size() != dimlens.size())
+    if (subscripts.size() != cxx_dim_lengths_.size())
     {
         std::string il = "{ ";
         for (const auto &it : subscripts)
-            il += std::to_string(it);
-        il += " ";
-
+            il += std::to_string(it) + " ";
         il += "}";
 
-        LOG_FATAL("Target get element mask, element initializer list ", il, " does not fit target ", this->_self());
+        LOG_FATAL("Target get element mask, element initializer list ", il, " does not fit ",
+                  std::to_string(cxx_dim_lengths_.size()), " dimensions");
         return -1;
     }
-
-    auto one_dim_bits = get_one_dim_bits();
-    auto msblsb_pair = get_element_msb_lsb_pair();
-    auto msb = msblsb_pair.first;
-    auto lsb = msblsb_pair.second;
-
-    if (one_dim_bits >
-        sizeof(QData) * 8) //(cxxtypedim.back().find("WData[") != std::string::npos) //(one_dim_bits > 64)
+    if (wide_ && (*(subscripts.end() - 1) + 1) == static_cast<size_t>(cxx_dim_lengths_.back()))
     {
-        int elementsubs = *(subscripts.end() - 1);
-        int elementsize = dimlens.back();
-        auto active_bits = one_dim_bits % (sizeof(WData) * 8);
-        // packed in WData
-        if (((elementsubs + 1) != elementsize) || (active_bits == 0) // fully used last element, i.e., no inactive rest
-        )
-        {
-            mask = WData(-1);
-        }
-        else
-        {
-            for (int i = 0; i < active_bits; ++i)
-            {
-                mask |= 1 << i;
-            }
-        }
+        return last_word_mask_;
     }
-    else
-    {
-        // unpacked
-        for (int i = lsb; i < msb + 1; ++i)
-            mask |= 1 << i;
-    }
-    return mask;
+    return element_mask_;
+}
+
+const TargetLayout &Target::get_layout(void) const
+{
+    std::call_once(layout_once_, [this]()
+                   { layout_ = std::make_unique<const TargetLayout>(get_dimensions(), get_bases(), get_bits()); });
+    return *layout_;
 }
 
 } // namespace types
@@ -23,6 +23,7 @@
 #include "vrtlmod/passes/pass.hpp"
 
 #include "vrtlmod/util/logging.hpp"
+#include "vrtlmod/util/timereport.hpp"
 
 #include <sstream>
 #include <string>
@@ -40,6 +41,14 @@ void VrtlParser::run(const clang::ast_matchers::MatchFinder::MatchResult &Result
 {
     auto ctx = Result.Context;
 
+    if (util::TimeReport::get().is_enabled())
+    {
+        for (const auto &it : Result.Nodes.getMap())
+        {
+            ++match_counts_[it.first];
+        }
+    }
+
     if (const clang::CompoundStmt *x = Result.Nodes.getNodeAs<clang::CompoundStmt>("compound_of_sequent_func"))
     {
         last_seq_compound_begin_ = x->getBeginLoc();
@@ -706,6 +715,11 @@ void VrtlParser::addMatcher(clang::ast_matchers::MatchFinder &finder)
 
 void VrtlParser::onEndOfTranslationUnit(void)
 {
+    if (!match_counts_.empty())
+    {
+        util::TimeReport::get().add_matches(match_counts_);
+        match_counts_.clear();
+    }
     for (const auto &pass : passes_)
     {
         pass->end_of_translation(*this);
@@ -714,7 +728,7 @@ void VrtlParser::onEndOfTranslationUnit(void)
 
 void VrtlParser::add_pass(std::unique_ptr<VrtlmodPass> pass)
 {
-    passes_.insert(std::move(pass));
+    passes_.push_back(std::move(pass));
 }
 
 VrtlParser::VrtlParser(Consumer &cons) : Handler(cons) {}
@@ -24,9 +24,20 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <functional>
+#include <map>
+#include <set>
+#include <algorithm>
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/VirtualFileSystem.h"
 
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/FrontendActions.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 
@@ -35,9 +46,13 @@ namespace fs = boost::filesystem;
 
 #include "vrtlmod/vrtlmod.hpp"
 #include "vrtlmod/core/core.hpp"
+#include "vrtlmod/core/astcache.hpp"
+#include "vrtlmod/core/buildcache.hpp"
+#include "vrtlmod/passes/rewritemacrosaction.hpp"
 
 #include "vrtlmod/util/utility.hpp"
 #include "vrtlmod/util/logging.hpp"
+#include "vrtlmod/util/timereport.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Frontend user option category
@@ -52,6 +67,38 @@ static llvm::cl::opt<std::string> WhiteListXmlFilename("wl-regxml", llvm::cl::Op
                                                        llvm::cl::desc("Specify input whitelist register xml"),
                                                        llvm::cl::value_desc("file name"), llvm::cl::cat(UserCat));
 ////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "target-rules". Sets input target selection rules
+static llvm::cl::opt<std::string> TargetRulesFilename(
+    "target-rules", llvm::cl::Optional,
+    llvm::cl::desc("Specify include/exclude rules refining the (whitelisted) injection targets"),
+    llvm::cl::value_desc("file name"), llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "api-shards". Sets number of source shards of the generated API
+static llvm::cl::opt<unsigned> ApiShards(
+    "api-shards", llvm::cl::Optional,
+    llvm::cl::desc("Split the compare and target dictionary code of the generated API into N source shards"),
+    llvm::cl::value_desc("N"), llvm::cl::init(1), llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "compare-table". Generates table-driven compare functions in the API
+static llvm::cl::opt<bool> CompareTable(
+    "compare-table", llvm::cl::Optional,
+    llvm::cl::desc("Compare targets in the generated API by loops over a descriptor table instead of unrolled code"),
+    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "td-instances". Instantiates the target dictionary entry types in a single source
+static llvm::cl::opt<bool> TDInstances(
+    "td-instances", llvm::cl::Optional,
+    llvm::cl::desc("Explicitly instantiate the target dictionary entry types once in <top>_td_instances.cpp instead "
+                   "of in every instrumented VRTL source"),
+    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "scoped-traversal". Limits the AST traversal of parse runs to the VRTL
+static llvm::cl::opt<bool> ScopedTraversal(
+    "scoped-traversal", llvm::cl::Optional,
+    llvm::cl::desc("Only traverse the verilated module classes and sequential evaluation functions in parse runs, "
+                   "skipping the Verilator, SystemC, and standard library headers"),
+    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
 /// \brief Frontend user option "out". Sets output directory path
 static llvm::cl::opt<std::string> OutputDir("out", llvm::cl::Optional, llvm::cl::desc("Specify output directory"),
                                             llvm::cl::value_desc("path"), llvm::cl::init("vrtlmod-out"),
@@ -69,6 +116,34 @@ static llvm::cl::opt<bool> Silent("silent", llvm::cl::Optional, llvm::cl::desc("
 static llvm::cl::opt<bool> XmlOnly("xml-only", llvm::cl::Optional,
                                    llvm::cl::desc("Only Elaborate and Analyze the given VRTL"), llvm::cl::cat(UserCat));
 ////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "fused-analysis".
+static llvm::cl::opt<bool> FusedAnalysis("fused-analysis", llvm::cl::Optional,
+                                         llvm::cl::desc("Elaborate and analyze the given VRTL in a single parse run"),
+                                         llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "ast-cache".
+static llvm::cl::opt<bool> UseASTCache(
+    "ast-cache", llvm::cl::Optional,
+    llvm::cl::desc("Serialize ASTs of the elaboration parse run and reuse them for the analysis"),
+    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "pch".
+static llvm::cl::opt<bool> UsePCH("pch", llvm::cl::Optional,
+                                  llvm::cl::desc("Precompile the Verilator runtime headers once for all parse runs"),
+                                  llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "incremental".
+static llvm::cl::opt<bool> Incremental(
+    "incremental", llvm::cl::Optional,
+    llvm::cl::desc("Keep a content-hash cache in the output directory and skip work for unchanged input"),
+    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "reuse-analysis". Sets input analysis database
+static llvm::cl::opt<std::string> ReuseAnalysis(
+    "reuse-analysis", llvm::cl::Optional,
+    llvm::cl::desc("Skip elaboration and analysis and restore their results from a *-vrtlmod.db of a previous run"),
+    llvm::cl::value_desc("file name"), llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
 /// \brief Frontend user option "print-td".
 static llvm::cl::opt<bool> PrintTD("print-td", llvm::cl::Optional,
                                    llvm::cl::desc("Print the common targetdictionary header file"),
@@ -86,16 +161,299 @@ static llvm::cl::opt<bool> Verbose("verbose", llvm::cl::Optional, llvm::cl::desc
                                    llvm::cl::cat(UserCat));
 static llvm::cl::alias VerboseA("v", llvm::cl::NotHidden, llvm::cl::desc("Alias for --verbose"),
                                 llvm::cl::aliasopt(Verbose));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "async-log".
+static llvm::cl::opt<bool> AsyncLog("async-log", llvm::cl::Optional,
+                                    llvm::cl::desc("Buffer log output and write it from a background thread"),
+                                    llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "time-report". Sets output time report JSON
+static llvm::cl::opt<std::string> TimeReportFilename(
+    "time-report", llvm::cl::Optional,
+    llvm::cl::desc("Write wall/CPU time and peak RSS of each stage, per-file timings, and match counts to a JSON"),
+    llvm::cl::value_desc("file name"), llvm::cl::cat(UserCat));
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Frontend user option "jobs". Sets number of translation units parsed in parallel
+static llvm::cl::opt<unsigned> Jobs("jobs", llvm::cl::Optional,
+                                    llvm::cl::desc("Number of translation units parsed in parallel (0: all cores)"),
+                                    llvm::cl::value_desc("N"), llvm::cl::init(1), llvm::cl::cat(UserCat));
+static llvm::cl::alias JobsA("j", llvm::cl::NotHidden, llvm::cl::desc("Alias for --jobs"), llvm::cl::aliasopt(Jobs));
 
 static llvm::cl::extrahelp CommonHelp(clang::tooling::CommonOptionsParser::HelpMessage);
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Path to the precompiled Verilator runtime headers. Empty if not used
+static std::string PrecompiledHeader;
+
 void auto_argument_adjust(clang::tooling::ClangTool &tool)
 {
-    for (auto const &it : util::auto_include_dirs)
+    if (!bool(NoAutoInclude))
+    {
+        for (auto const &it : util::auto_include_dirs)
+        {
+            clang::tooling::ArgumentsAdjuster a = clang::tooling::getInsertArgumentAdjuster(it.c_str());
+            tool.appendArgumentsAdjuster(a);
+        }
+    }
+    if (!PrecompiledHeader.empty())
+    {
+        tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
+            { "-include-pch", PrecompiledHeader }, clang::tooling::ArgumentInsertPosition::END));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns compilation database for files generated by vrtlmod, using the compile flags of a given VRTL file
+/// \return nullptr if there is no compile command for file
+std::unique_ptr<clang::tooling::CompilationDatabase> derive_compilations(const clang::tooling::CompilationDatabase &db,
+                                                                         const std::string &file)
+{
+    auto cmds = db.getCompileCommands(file);
+    if (cmds.empty())
+    {
+        return nullptr;
+    }
+    // compile flags of the VRTL file without driver and input file
+    std::vector<std::string> args;
+    for (size_t i = 1; i < cmds.front().CommandLine.size(); ++i)
+    {
+        const auto &arg = cmds.front().CommandLine[i];
+        if (arg != file && arg != cmds.front().Filename)
+        {
+            args.push_back(arg);
+        }
+    }
+    return std::make_unique<clang::tooling::FixedCompilationDatabase>(cmds.front().Directory, args);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Precompile the Verilator runtime headers with the compile command of a given VRTL file
+/// \details The runtime headers are never altered by vrtlmod, the PCH stays valid for all parse runs
+/// \return Path to the PCH, empty on failure
+std::string build_pch(const clang::tooling::CompilationDatabase &db, const std::string &file, const fs::path &dir)
+{
+    auto header = dir / "vrtlmod_pch.h";
+    auto pch = dir / "vrtlmod_pch.h.pch";
+    {
+        std::ofstream out(header.string());
+        out << "#include \"verilated.h\"\n";
+        if (bool(SystemC))
+        {
+            out << "#include \"verilated_sc.h\"\n";
+        }
+    }
+
+    auto pch_db = derive_compilations(db, file);
+    if (!pch_db)
+    {
+        LOG_WARNING("No compile command for [", file, "]. Can not build precompiled header.");
+        return "";
+    }
+
+    clang::tooling::ClangTool tool(*pch_db, { header.string() });
+    // default adjusters force -fsyntax-only, which suppresses the PCH output file
+    tool.clearArgumentsAdjusters();
+    tool.appendArgumentsAdjuster(clang::tooling::getClangStripOutputAdjuster());
+    auto_argument_adjust(tool);
+    tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
+        { "-x", "c++-header" }, clang::tooling::ArgumentInsertPosition::BEGIN));
+    tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
+        { "-o", pch.string() }, clang::tooling::ArgumentInsertPosition::END));
+    if (tool.run(clang::tooling::newFrontendActionFactory<clang::GeneratePCHAction>().get()))
+    {
+        LOG_WARNING("Failed to build precompiled header [", pch.string(), "]. Continue without.");
+        return "";
+    }
+    return pch.string();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Call a function on each of the given files
+/// \param jobs Number of files processed in parallel (1: in order, 0: all cores)
+/// \return 0 on success, otherwise the last non-zero return code of func
+int foreach_file(const std::vector<std::string> &files, const std::function<int(const std::string &)> &func,
+                 unsigned jobs)
+{
+    std::atomic<int> err{ 0 };
+    std::mutex except_mutex;
+    std::exception_ptr except{ nullptr };
+
+    auto run_file = [&](const std::string &file)
+    {
+        util::TimeReport::File time(file);
+        try
+        {
+            if (int ret = func(file))
+            {
+                err = ret;
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(except_mutex);
+            if (!except)
+            {
+                except = std::current_exception();
+            }
+        }
+    };
+
+    if (jobs == 1)
+    {
+        for (const auto &file : files)
+        {
+            run_file(file);
+        }
+    }
+    else
+    {
+        llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+        for (const auto &file : files)
+        {
+            pool.async([&run_file, file]() { run_file(file); });
+        }
+        pool.wait();
+    }
+
+    if (except)
+    {
+        std::rethrow_exception(except);
+    }
+    return err;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Call a function on a ClangTool instance of its own for each of the given files
+/// \param jobs Number of files processed in parallel (1: in order, 0: all cores)
+/// \return 0 on success, otherwise the last non-zero return code of func
+int foreach_tool(const clang::tooling::CompilationDatabase &db, const std::vector<std::string> &files,
+                 const std::function<int(clang::tooling::ClangTool &)> &func, unsigned jobs)
+{
+    return foreach_file(
+        files,
+        [&](const std::string &file)
+        {
+            // each tool gets its own file system, so that working directories are not shared between threads
+            clang::tooling::ClangTool tool(db, { file }, std::make_shared<clang::PCHContainerOperations>(),
+                                           llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(
+                                               llvm::vfs::createPhysicalFileSystem().release()));
+            auto_argument_adjust(tool);
+            return func(tool);
+        },
+        jobs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Run a tool action on each of the given files with its own ClangTool instance
+/// \param jobs Number of files processed in parallel (1: in order, 0: all cores)
+/// \return 0 on success, otherwise the last non-zero ClangTool return code
+int run_tool(const clang::tooling::CompilationDatabase &db, const std::vector<std::string> &files,
+             clang::tooling::ToolAction *action, unsigned jobs)
+{
+    return foreach_tool(
+        db, files, [action](clang::tooling::ClangTool &tool) { return tool.run(action); }, jobs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the compile commands of a file as a single string
+std::string get_compile_command(const clang::tooling::CompilationDatabase &db, const std::string &file)
+{
+    std::string ret;
+    for (const auto &cmd : db.getCompileCommands(file))
+    {
+        for (const auto &arg : cmd.CommandLine)
+        {
+            ret += " " + arg;
+        }
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the VRTL headers next to the given input files, i.e., the headers the input sources include
+std::set<std::string> get_vrtl_headers(const std::vector<std::string> &files)
+{
+    std::set<fs::path> dirs;
+    for (const auto &file : files)
+    {
+        dirs.insert(fs::absolute(file).parent_path());
+    }
+    std::set<std::string> headers;
+    for (const auto &dir : dirs)
     {
-        clang::tooling::ArgumentsAdjuster a = clang::tooling::getInsertArgumentAdjuster(it.c_str());
-        tool.appendArgumentsAdjuster(a);
+        if (!fs::is_directory(dir))
+        {
+            continue;
+        }
+        for (const auto &it : fs::directory_iterator(dir))
+        {
+            const auto ext = it.path().extension();
+            if (fs::is_regular_file(it.path()) && (ext == ".h" || ext == ".hpp"))
+            {
+                headers.insert(it.path().string());
+            }
+        }
     }
+    return headers;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns key of a vrtlmod run over the given input files
+/// \details Hash of the vrtlmod version, output relevant options, whitelist, compile commands, input files, and the
+/// VRTL headers next to the input files, which are parsed even if not given as input files
+std::string get_run_key(const clang::tooling::CompilationDatabase &db, std::vector<std::string> files)
+{
+    std::sort(files.begin(), files.end());
+    std::stringstream key;
+    key << vrtlmod::get_version() << ";systemc=" << bool(SystemC) << ";auto-include=" << !bool(NoAutoInclude)
+        << ";api-shards=" << ApiShards << ";compare-table=" << bool(CompareTable)
+        << ";td-instances=" << bool(TDInstances);
+    if (!WhiteListXmlFilename.empty())
+    {
+        key << ";wl=" << vrtlmod::BuildCache::hash_file(WhiteListXmlFilename.c_str());
+    }
+    if (!TargetRulesFilename.empty())
+    {
+        key << ";rules=" << vrtlmod::BuildCache::hash_file(TargetRulesFilename.c_str());
+    }
+    if (!ReuseAnalysis.empty())
+    {
+        key << ";db=" << vrtlmod::BuildCache::hash_file(ReuseAnalysis.c_str());
+    }
+    for (const auto &file : files)
+    {
+        key << ";" << file << "=" << vrtlmod::BuildCache::hash_file(file) << get_compile_command(db, file);
+    }
+    for (const auto &header : get_vrtl_headers(files))
+    {
+        key << ";" << header << "=" << vrtlmod::BuildCache::hash_file(header);
+    }
+    return vrtlmod::BuildCache::hash(key.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Restores cleaned content of unchanged files from the cache
+/// \param files Files to be cleaned. Restored files are removed
+/// \return Cache keys of the remaining files
+std::map<std::string, std::string> restore_cleaned(const vrtlmod::BuildCache &cache,
+                                                   const clang::tooling::CompilationDatabase &db,
+                                                   std::vector<std::string> &files)
+{
+    std::map<std::string, std::string> keys;
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [&](const auto &file)
+                               {
+                                   // the macro cleanup depends on the compile flags and defines
+                                   auto key = cache.get_file_key(file, get_compile_command(db, file));
+                                   if (cache.restore_cleaned(file, key))
+                                   {
+                                       return true;
+                                   }
+                                   keys[file] = key;
+                                   return false;
+                               }),
+                files.end());
+    return keys;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -103,10 +461,23 @@ void auto_argument_adjust(clang::tooling::ClangTool &tool)
 int main(int argc, const char **argv)
 {
     int err = 0;
+    // a run only succeeds if all of its stages do, keep the last failure
+    auto set_err = [&err](int ret)
+    {
+        if (ret != 0)
+        {
+            err = ret;
+        }
+    };
 
     llvm::Expected<clang::tooling::CommonOptionsParser> op =
         clang::tooling::CommonOptionsParser::create(argc, argv, UserCat);
 
+    if (bool(AsyncLog))
+    {
+        util::logging::set_async(true);
+    }
+
     if (bool(Silent))
     {
         util::logging::toggle_silent();
@@ -119,7 +490,24 @@ int main(int argc, const char **argv)
         LOG_VERBOSE("Executing verbosely - Verbose output active");
     }
 
+    util::TimeReport::Writer time_report(TimeReportFilename.c_str());
+
+    if (bool(FusedAnalysis) && bool(UseASTCache))
+    {
+        LOG_ERROR("--fused-analysis and --ast-cache can not be combined, the fused parse run leaves no second "
+                  "parse run to cache the ASTs for");
+        return 1;
+    }
+    if (bool(CompareTable) && bool(SystemC))
+    {
+        LOG_ERROR("--compare-table and --systemc can not be combined, SystemC top ports are no plain memory the "
+                  "compare descriptors can point to");
+        return 1;
+    }
+
     vrtlmod::VrtlmodCore core(OutputDir.c_str(), SystemC);
+    core.set_td_instances(TDInstances);
+    core.set_scoped_traversal(ScopedTraversal);
 
     if (bool(PrintTD))
     {
@@ -134,90 +522,239 @@ int main(int argc, const char **argv)
 
     std::vector<std::string> in_sources = op->getSourcePathList();
 
-    // prepare *.cpp /*.cc files: create, de-macro, clean comments.
-    auto sources = core.prepare_sources(in_sources, Overwrite);
+    std::unique_ptr<vrtlmod::BuildCache> cache{ nullptr };
+    std::string run_key;
+    if (bool(Incremental))
+    {
+        cache = std::make_unique<vrtlmod::BuildCache>(fs::path(OutputDir.c_str()) / ".vrtlmod-cache");
+        run_key = get_run_key(op->getCompilations(), in_sources);
+        if (!bool(Overwrite) && cache->is_up_to_date(run_key))
+        {
+            LOG_INFO("Output in [", OutputDir.c_str(), "] is up to date. Nothing to do.");
+            return 0;
+        }
+        // the output is overwritten from here on, it is only up to date again once this run completes
+        cache->set_outdated();
+    }
 
-    // prepare *.h / *.hpp files: create, de-macro, clean comments.
-    auto headers = core.prepare_headers(in_sources, Overwrite);
+    std::vector<std::string> sources, headers;
+    {
+        util::TimeReport::Stage stage("prepare");
+        // prepare *.cpp /*.cc files: create, de-macro, clean comments.
+        sources = core.prepare_sources(in_sources, Overwrite);
+
+        // prepare *.h / *.hpp files: create, de-macro, clean comments.
+        headers = core.prepare_headers(in_sources, Overwrite, Jobs);
+    }
 
     auto srcs_and_headers = sources;
     srcs_and_headers.insert(srcs_and_headers.end(), headers.begin(), headers.end());
-    auto srcs_and_headers_wo_symsh = srcs_and_headers;
+    core.set_vrtl_files(srcs_and_headers);
 
-    clang::tooling::ClangTool CommentTool(op->getCompilations(), srcs_and_headers);
-    if (!bool(NoAutoInclude))
+    if (bool(UsePCH) && !sources.empty())
     {
-        auto_argument_adjust(CommentTool);
+        util::TimeReport::Stage stage("pch");
+        LOG_INFO("Precompile Verilator headers ...");
+        PrecompiledHeader = build_pch(op->getCompilations(), sources.front(), core.get_output_dir());
+        LOG_INFO("... done");
+    }
+
+    // only files whose content changed since the last run go through the cleanup passes
+    auto clean_sources = sources;
+    auto clean_headers = headers;
+    std::map<std::string, std::string> clean_keys;
+    if (cache)
+    {
+        clean_keys = restore_cleaned(*cache, op->getCompilations(), clean_sources);
+        auto header_keys = restore_cleaned(*cache, op->getCompilations(), clean_headers);
+        clean_keys.insert(header_keys.begin(), header_keys.end());
+        LOG_INFO("Restored ", std::to_string(srcs_and_headers.size() - clean_keys.size()), " cleaned files from cache");
     }
-    LOG_INFO("Run CommentTool on sources ...");
-    err = CommentTool.run(vrtlmod::CreateCommentRewritePass(core).get());
-    LOG_INFO("... done");
 
-    // create a new Clang Tool instance for Macro cleanup in source and header files except Verilated Symboltable header
-    // which does not need cleanup, but breaks the MacroTool Lexer
+    // comment cleanup is textual and does not depend on other files
+    auto clean_files = clean_sources;
+    clean_files.insert(clean_files.end(), clean_headers.begin(), clean_headers.end());
+    {
+        util::TimeReport::Stage stage("comment");
+        LOG_INFO("Clean nested comments in sources ...");
+        set_err(foreach_file(clean_files, vrtlmod::transform::rewrite::clean_nested_comments, Jobs));
+        LOG_INFO("... done");
+    }
+
+    // run Macro cleanup in source and header files except Verilated Symboltable header which does not need cleanup,
+    // but breaks the MacroTool Lexer
     // FIXME: MacroTool only breaks for large VRTL models on Symboltable
-    srcs_and_headers_wo_symsh.erase(std::remove_if(srcs_and_headers_wo_symsh.begin(), srcs_and_headers_wo_symsh.end(),
-                                                   [](const auto &x)
-                                                   { return (x.find("__Syms.h") != std::string::npos); }));
-    clang::tooling::ClangTool MacroTool(op->getCompilations(), srcs_and_headers_wo_symsh);
-    if (!bool(NoAutoInclude))
+    // MacroTool rewrites the files it parses. Sources are never included by other files and can be processed in
+    // parallel, headers include each other and are processed in order.
+    auto headers_wo_symsh = clean_headers;
+    headers_wo_symsh.erase(std::remove_if(headers_wo_symsh.begin(), headers_wo_symsh.end(),
+                                          [](const auto &x) { return (x.find("__Syms.h") != std::string::npos); }),
+                           headers_wo_symsh.end());
     {
-        auto_argument_adjust(MacroTool);
+        util::TimeReport::Stage stage("macro");
+        LOG_INFO("Run MacroTool on sources ...");
+        set_err(run_tool(op->getCompilations(), clean_sources, vrtlmod::CreateMacroRewritePass(core).get(), Jobs));
+        set_err(run_tool(op->getCompilations(), headers_wo_symsh, vrtlmod::CreateMacroRewritePass(core).get(), 1));
+        LOG_INFO("... done");
     }
-    LOG_INFO("Run MacroTool on sources ...");
-    err = MacroTool.run(vrtlmod::CreateMacroRewritePass(core).get());
-    LOG_INFO("... done");
 
-    // create a new Clang Tool instance for Macro cleanup in source files
-    clang::tooling::ClangTool stage1_ParserTool(op->getCompilations(), srcs_and_headers);
-    if (!bool(NoAutoInclude))
+    if (cache && err == 0)
     {
-        auto_argument_adjust(stage1_ParserTool);
+        for (const auto &it : clean_keys)
+        {
+            cache->store_cleaned(it.first, it.second);
+        }
     }
-    LOG_INFO("Analyze VRTL sources (elaboration)...");
-    err = stage1_ParserTool.run(vrtlmod::CreateElaboratePass(core).get());
-    LOG_INFO("... done");
 
-    clang::tooling::ClangTool stage2_ParserTool(op->getCompilations(), srcs_and_headers);
-    if (!bool(NoAutoInclude))
+    if (!ReuseAnalysis.empty())
     {
-        auto_argument_adjust(stage2_ParserTool);
+        // the database refers to the prepared files in the output directory, which are the same as in its run
+        util::TimeReport::Stage stage("restore analysis");
+        LOG_INFO("Restore VRTL elaboration and analysis from [", ReuseAnalysis.c_str(), "] ...");
+        if (!core.read_analysis_db(ReuseAnalysis.c_str()))
+        {
+            return 1;
+        }
+        LOG_INFO("... done");
+    }
+    else if (bool(FusedAnalysis))
+    {
+        // injection locations can be found before their variable is elaborated, resolve them after the parse run
+        core.defer_injection_locations(true);
+        util::TimeReport::Stage stage("elaborate+analyze");
+        LOG_INFO("Analyze VRTL sources (elaboration) and for possible injection points ...");
+        set_err(
+            run_tool(op->getCompilations(), srcs_and_headers, vrtlmod::CreateElaborateAnalyzePass(core).get(), Jobs));
+        core.resolve_deferred_injection_locations();
+        core.defer_injection_locations(false);
+        LOG_INFO("... done");
+    }
+    else if (bool(UseASTCache))
+    {
+        // analysis passes do not change the VRTL, the ASTs of the elaboration stay valid for the analysis
+        vrtlmod::ASTCache cache(core.get_output_dir() / "ast");
+
+        auto stage = std::make_unique<util::TimeReport::Stage>("elaborate");
+        LOG_INFO("Analyze VRTL sources (elaboration) and cache ASTs ...");
+        auto elaborate = vrtlmod::CreateElaborateASTPass(core);
+        set_err(foreach_tool(
+            op->getCompilations(), srcs_and_headers,
+            [&](clang::tooling::ClangTool &tool)
+            {
+                std::vector<std::unique_ptr<clang::ASTUnit>> asts;
+                int ret = tool.buildASTs(asts);
+                for (auto &ast : asts)
+                {
+                    elaborate(*ast);
+                    cache.store(*ast);
+                }
+                return ret;
+            },
+            Jobs));
+        LOG_INFO("... done");
+
+        stage.reset();
+        stage = std::make_unique<util::TimeReport::Stage>("analyze");
+        LOG_INFO("Analyze cached VRTL ASTs for possible injection points ...");
+        auto analyze = vrtlmod::CreateAnalyzeASTPass(core);
+        std::mutex uncached_mutex;
+        std::vector<std::string> uncached;
+        set_err(foreach_file(
+            srcs_and_headers,
+            [&](const std::string &file)
+            {
+                if (auto ast = cache.load(file))
+                {
+                    analyze(*ast);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> lock(uncached_mutex);
+                    uncached.push_back(file);
+                }
+                return 0;
+            },
+            Jobs));
+        if (!uncached.empty())
+        {
+            set_err(run_tool(op->getCompilations(), uncached, vrtlmod::CreateAnalyzePass(core).get(), Jobs));
+        }
+        LOG_INFO("... done");
+    }
+    else
+    {
+        {
+            util::TimeReport::Stage stage("elaborate");
+            LOG_INFO("Analyze VRTL sources (elaboration)...");
+            set_err(run_tool(op->getCompilations(), srcs_and_headers, vrtlmod::CreateElaboratePass(core).get(), Jobs));
+            LOG_INFO("... done");
+        }
+        {
+            util::TimeReport::Stage stage("analyze");
+            LOG_INFO("Analyze VRTL sources for possible injection points ...");
+            set_err(run_tool(op->getCompilations(), srcs_and_headers, vrtlmod::CreateAnalyzePass(core).get(), Jobs));
+            LOG_INFO("... done");
+        }
     }
-    LOG_INFO("Analyze VRTL sources for possible injection points ...");
-    err = stage2_ParserTool.run(vrtlmod::CreateAnalyzePass(core).get());
-    LOG_INFO("... done");
 
-    core.build_xml();
+    {
+        util::TimeReport::Stage stage("xml");
+        core.build_xml();
+        if (ReuseAnalysis.empty())
+        {
+            core.write_analysis_db(core.get_analysis_db_path());
+        }
+    }
 
     if (bool(XmlOnly))
         return 0;
 
-    core.initialize_injection_targets(WhiteListXmlFilename);
+    {
+        util::TimeReport::Stage stage("target filter");
+        core.initialize_injection_targets(WhiteListXmlFilename, TargetRulesFilename);
+    }
 
+    auto stage = std::make_unique<util::TimeReport::Stage>("header rewrite");
     LOG_INFO("Rewrite VRTL headers for injectable signals ...");
-    for (auto const &header_file : headers)
+    auto batch_db = derive_compilations(op->getCompilations(), sources.empty() ? "" : sources.front());
+    if (Jobs == 1 && batch_db)
     {
-        clang::tooling::ClangTool stage3_SigDeclRewriterTool(op->getCompilations(), { header_file });
-        if (!bool(NoAutoInclude))
+        // a single parse run on a translation unit including all headers rewrites all of them
+        auto batch = core.get_output_dir() / "vrtlmod_headers.cpp";
         {
-            auto_argument_adjust(stage3_SigDeclRewriterTool);
+            std::ofstream out(batch.string());
+            for (const auto &it : headers)
+            {
+                out << "#include \"" << fs::absolute(it).string() << "\"\n";
+            }
         }
-        err = stage3_SigDeclRewriterTool.run(vrtlmod::CreateSignalDeclPass(core).get());
+        set_err(run_tool(*batch_db, { batch.string() }, vrtlmod::CreateBatchSignalDeclPass(core).get(), 1));
+        fs::remove(batch);
     }
-    LOG_INFO("... done");
-
-    clang::tooling::ClangTool stage3_InjectionExprRewriterTool(op->getCompilations(), sources);
-    if (!bool(NoAutoInclude))
+    else
     {
-        auto_argument_adjust(stage3_InjectionExprRewriterTool);
+        set_err(run_tool(op->getCompilations(), headers, vrtlmod::CreateSignalDeclPass(core).get(), Jobs));
     }
+    LOG_INFO("... done");
+
+    stage.reset();
+    stage = std::make_unique<util::TimeReport::Stage>("injection rewrite");
     LOG_INFO("Rewrite VRTL sources for injection points ...");
-    err = stage3_InjectionExprRewriterTool.run(vrtlmod::CreateInjectionPass(core).get());
+    set_err(run_tool(op->getCompilations(), sources, vrtlmod::CreateInjectionPass(core).get(), Jobs));
     LOG_INFO("... done");
 
+    stage.reset();
+    stage = std::make_unique<util::TimeReport::Stage>("api");
     LOG_INFO("Generate API ...");
-    core.build_api();
+    core.build_api(ApiShards, Jobs, CompareTable);
     LOG_INFO("... done");
+    stage.reset();
+
+    if (cache && err == 0)
+    {
+        // all stages succeeded, failures of the API generation throw
+        cache->set_up_to_date(run_key);
+    }
 
     return err;
 }
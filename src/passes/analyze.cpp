@@ -76,10 +76,11 @@ void AnalyzePass::action(const VrtlParser &parser, const clang::ast_matchers::Ma
         {
             LOG_VERBOSE("check target status of: `{signal} ", parser.get_source_code_str(assignee), " aka `",
                         assignee->getMemberNameInfo().getAsString(), "` of `{module}:", parent->getNameAsString(), "`");
+            auto lock = get_core().lock_ctx();
             if (const types::Variable *var = get_core().add_injection_location(assignee, parent, *ctx))
             {
                 LOG_INFO("injection location for [", var->get_id(), "] found assignment:\n  \\- ",
-                         parser.get_source_code_str(expr), " at: ", var->get_inj_loc());
+                         parser.get_source_code_str(expr), " at: ", var->sea_locs_.back().to_string());
                 LOG_VERBOSE("AST:\n", util::logging::dump_to_str<const clang::Stmt *>(expr, ctx));
             }
         }
@@ -38,6 +38,7 @@ void ElaboratePass::action(const VrtlParser &parser, const clang::ast_matchers::
     if (const clang::CXXRecordDecl *x = Result.Nodes.getNodeAs<clang::CXXRecordDecl>("module"))
     {
         LOG_VERBOSE("{module}: ", x->getNameAsString());
+        auto lock = get_core().lock_ctx();
         if (const auto *module = get_core().add_module(x, *ctx))
         {
             LOG_INFO("{module:} found new module declaration [", module->get_id(), "]");
@@ -50,10 +51,11 @@ void ElaboratePass::action(const VrtlParser &parser, const clang::ast_matchers::
     if (const clang::FieldDecl *x = Result.Nodes.getNodeAs<clang::FieldDecl>("cell_decl"))
     {
         LOG_VERBOSE("{cell_decl}: ", x->getNameAsString(), "\n  \\-", parser.get_source_code_str(x));
+        auto lock = get_core().lock_ctx();
         if (const auto *cell = get_core().add_cell(x, *ctx))
         {
             LOG_INFO("{cell}: found cell member [", cell->get_id(), "] of type [", cell->get_type(), "] in module [",
-                     types::Module(cell->parent()).get_id(), "]");
+                     cell->get_parent()->get_id(), "]");
         }
     }
     if (const clang::FieldDecl *x = Result.Nodes.getNodeAs<clang::FieldDecl>("topref_decl"))
@@ -61,6 +63,7 @@ void ElaboratePass::action(const VrtlParser &parser, const clang::ast_matchers::
         LOG_VERBOSE("{topref_decl}: ", x->getNameAsString(), "\n  \\-", parser.get_source_code_str(x));
         if (const auto *module = Result.Nodes.getNodeAs<clang::CXXRecordDecl>("module"))
         {
+            auto lock = get_core().lock_ctx();
             if (const auto *cell = get_core().set_top_cell(x, *ctx))
             {
                 LOG_INFO("{top cell} found top cell [", cell->get_id(), "] of type [", cell->get_type(), "]");
@@ -72,10 +75,11 @@ void ElaboratePass::action(const VrtlParser &parser, const clang::ast_matchers::
     {
         LOG_VERBOSE("{signal_decl}: ", x->getNameAsString(), "\n  `\\-", parser.get_source_code_str(x));
         LOG_VERBOSE("AST:\n", util::logging::dump_to_str(x));
+        auto lock = get_core().lock_ctx();
         if (const auto *var = get_core().add_variable(x, *ctx, parser.getRewriter()))
         {
             LOG_INFO("{variable}: found variable member [", var->get_id(), "] of type [", var->get_type(),
-                     "] in module [", types::Module(var->parent()).get_id(), "]");
+                     "] in module [", var->get_parent().get_id(), "]");
         }
     }
 }
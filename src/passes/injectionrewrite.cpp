@@ -51,6 +51,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
             // LOG_INFO("Matcher ENTER sequent body of: \n\t", active_sequent_func_->_self());
             active_sequent_func_ = nullptr; // reset active
             active_compound_ = nullptr;
+            open_compounds_.clear();
         }
     }
 
@@ -59,6 +60,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
         active_sequent_func_ = f;
         LOG_INFO("Matcher ENTER sequent body of: \n\t", active_sequent_func_->getNameAsString());
         map_seq_compounds_[active_sequent_func_] = {};
+        open_compounds_.clear();
         map_injected_targets_[active_sequent_func_] = {};
         map_nonliteral_subscript_targets_[active_sequent_func_] = {};
     }
@@ -77,9 +79,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
             {
                 if (active_sequent_func_ != nullptr)
                 {
-                    auto compound = std::make_shared<CompoundStmt>(c, parser);
-                    active_compound_ = compound.get();
-                    map_seq_compounds_.at(active_sequent_func_).push_back(compound);
+                    add_compound(std::make_shared<CompoundStmt>(c, parser));
                 }
                 // TODO: maybe add here a locator to the needed sequent function to assign this compound to instead of
                 // leaving on FATAL.
@@ -92,9 +92,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
         {
             if (active_sequent_func_ != nullptr)
             {
-                auto compound = std::make_shared<CompoundStmt>(c, parser);
-                active_compound_ = compound.get();
-                map_seq_compounds_.at(active_sequent_func_).push_back(compound);
+                add_compound(std::make_shared<CompoundStmt>(c, parser));
             }
         }
     }
@@ -470,7 +468,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
 
             if (asgn.get() != nullptr && active_compound_ != nullptr)
             {
-                auto comp = get_finest_compound(active_sequent_func_, asgn->get_base_expr());
+                auto comp = get_finest_compound(asgn->get_base_expr());
                 comp->add_assignment(asgn);
                 map_injected_targets_.at(active_sequent_func_).insert({ prefix, t });
                 if (has_non_literal)
@@ -500,7 +498,7 @@ void InjectionRewriter::action(const VrtlParser &parser,
                     if (assignee != nullptr && parent != nullptr)
                     {
                         auto asgn = std::make_shared<CallSInj>(x, assignee, prefix, t);
-                        auto comp = get_finest_compound(active_sequent_func_, asgn->get_base_expr());
+                        auto comp = get_finest_compound(asgn->get_base_expr());
                         // active_compound_->add_assignment(asgn);
                         comp->add_assignment(asgn);
                         map_injected_targets_.at(active_sequent_func_).insert({ prefix, t });
@@ -706,39 +704,39 @@ void InjectionRewriter::write_sequent_injections(void) const
     }
 }
 
-std::shared_ptr<InjectionRewriter::CompoundStmt> InjectionRewriter::get_finest_compound(const clang::FunctionDecl *f,
-                                                                                        const clang::Expr *expr) const
+namespace
 {
-    std::shared_ptr<CompoundStmt> ret{ nullptr };
-    auto in_range = [](const clang::Expr *a, const auto *b) -> bool
-    {
-        if ((a->getBeginLoc().getRawEncoding() >= b->getBeginLoc().getRawEncoding()) &&
-            (a->getEndLoc().getRawEncoding() <= b->getEndLoc().getRawEncoding()))
-        {
-            return true;
-        }
-        return false;
-    };
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns true if the source range of `outer` includes the one of `inner`
+bool encloses(const clang::Stmt *outer, const clang::Stmt *inner)
+{
+    return (inner->getBeginLoc().getRawEncoding() >= outer->getBeginLoc().getRawEncoding()) &&
+           (inner->getEndLoc().getRawEncoding() <= outer->getEndLoc().getRawEncoding());
+}
+} // namespace
 
-    for (auto &comp : map_seq_compounds_.at(f))
+void InjectionRewriter::add_compound(std::shared_ptr<CompoundStmt> compound) const
+{
+    while (!open_compounds_.empty() && !encloses(open_compounds_.back()->c_, compound->c_))
     {
-        if (in_range(expr, comp->c_))
-        {
-            if (!ret)
-            {
-                ret = comp; // none found yet
-            }
-            else
-            {
-                if (ret->c_->getBeginLoc() < comp->c_->getBeginLoc())
-                {
-                    ret = comp; // one more fine grain comp found
-                }
-            }
-        }
+        open_compounds_.pop_back();
     }
+    // a statement matched by several compound matchers keeps its first record
+    if (open_compounds_.empty() || open_compounds_.back()->c_ != compound->c_)
+    {
+        open_compounds_.push_back(compound);
+    }
+    active_compound_ = compound.get();
+    map_seq_compounds_.at(active_sequent_func_).push_back(compound);
+}
 
-    return ret;
+std::shared_ptr<InjectionRewriter::CompoundStmt> InjectionRewriter::get_finest_compound(const clang::Expr *expr) const
+{
+    while (!open_compounds_.empty() && !encloses(open_compounds_.back()->c_, expr))
+    {
+        open_compounds_.pop_back();
+    }
+    return open_compounds_.empty() ? nullptr : open_compounds_.back();
 }
 
 std::string get_sequent_injection_stmt(const types::Target &t, std::vector<std::string> subscripts)
@@ -23,6 +23,10 @@
 #include "vrtlmod/util/logging.hpp"
 #include "vrtlmod/util/utility.hpp"
 
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <cctype>
+
 namespace vrtlmod
 {
 namespace transform
@@ -48,70 +52,101 @@ void RewriteMacrosAction::ExecuteAction()
     out.close();
 }
 
-void RewriteCommentsAction::ExecuteAction(void)
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Returns comment with escaped nested multi-line comments, e.g., `// a /* b */` to `// a \/\* b \*\/`
+static std::string escape_nested_comment(llvm::StringRef comment)
 {
-    LOG_VERBOSE("> Rewrite inlined (/* */) comments within comments (//) in file", getCurrentFile().str());
-
-    clang::CompilerInstance &CI = getCompilerInstance();
-    clang::Preprocessor &PP = CI.getPreprocessor();
-    clang::SourceManager &SM = PP.getSourceManager();
-    clang::Rewriter Rewrite;
-    Rewrite.setSourceMgr(SM, PP.getLangOpts());
-    clang::RewriteBuffer &RB = Rewrite.getEditBuffer(SM.getMainFileID());
-
-    ch_.set_file(getCurrentFile());
-    ch_.set_rewrite_buffer(RB);
-    CI.getPreprocessor().addCommentHandler(&ch_);
-
-    llvm::raw_null_ostream null_out;
-    RewriteMacrosInInput(CI.getPreprocessor(), &null_out);
-
-    std::ofstream out(getCurrentFile().str().c_str());
-    out << std::string(RB.begin(), RB.end());
-    out.flush();
-    out.close();
-    CI.getPreprocessor().removeCommentHandler(&ch_);
+    std::string new_str = comment.substr(2).str();
+    util::strhelp::replaceAll(new_str, "/*", "\\/\\*");
+    util::strhelp::replaceAll(new_str, "*/", "\\*\\/");
+    if (comment.startswith("/*")) // original comment embedding another inline comment is itself an inline comment (may
+                                  // happen if RewriteMacrosAction had been already done)
+    {
+        new_str += "*/";
+    }
+    return comment.substr(0, 2).str() + new_str;
 }
 
-bool RewriteCommentsAction::CommentHandler::HandleComment(clang::Preprocessor &PP, clang::SourceRange Comment)
+int clean_nested_comments(const std::string &file)
 {
-    clang::SourceManager &sm = PP.getSourceManager();
-    if (sm.getFilename(Comment.getBegin()) == file_)
-    {
-        auto comment_loc_str = Comment.printToString(sm);
-        std::pair<clang::FileID, unsigned int> startLoc = sm.getDecomposedLoc(Comment.getBegin());
-        std::pair<clang::FileID, unsigned int> endLoc = sm.getDecomposedLoc(Comment.getEnd());
+    LOG_VERBOSE("> Rewrite inlined (/* */) comments within comments (//) in file", file);
 
-        llvm::StringRef fileData = sm.getBufferData(startLoc.first);
-
-        auto comment_str = fileData.substr(startLoc.second, endLoc.second - startLoc.second).str();
+    auto buffer = llvm::MemoryBuffer::getFile(file); // memory-maps large files
+    if (!buffer)
+    {
+        LOG_ERROR("Failed to read [", file, "]: ", buffer.getError().message());
+        return 1;
+    }
+    llvm::StringRef data = (*buffer)->getBuffer();
 
-        // remove multi-line comments (`/**/`) inlined in single-line comments (`//`)`, e.g., // ... /* some text */ ...
-        // clang::RewriteMacrosAction::RewriteMacrosInInput can not detect those and would result in /* // ... /*
-        // some text */ ...  */ which breaks preprocessor at first /**/ pair
-        if (auto inline_pos_start = comment_str.find("/*", 2); inline_pos_start != std::string::npos)
+    std::string out;
+    size_t copied = 0; // data up to here is in out
+    size_t i = 0;
+    const size_t n = data.size();
+    while (i < n)
+    {
+        char c = data[i];
+        if (c == '"' || (c == '\'' && (i == 0 || !std::isalnum(static_cast<unsigned char>(data[i - 1])))))
         {
-            clang::Rewriter rw;
-            rw.setSourceMgr(sm, PP.getLangOpts());
-            clang::RewriteBuffer &RB = rw.getEditBuffer(sm.getMainFileID());
-
-            std::cout << ">>>[c]: was `" << comment_str << "`" << std::endl;
-            std::string new_str;
-            new_str = comment_str.substr(2);
-            util::strhelp::replaceAll(new_str, "/*", "\\/\\*");
-            util::strhelp::replaceAll(new_str, "*/", "\\*\\/");
-            if (comment_str.find("/*") == 0) // original comment embedding another inline comment is itself an inline
-                                             // comment (may happen if RewriteMacrosAction had been already done)
+            // skip string or character literal, digit separators (1'000) are excluded above
+            size_t j = i + 1;
+            while (j < n && data[j] != c && data[j] != '\n')
             {
-                new_str += "*/";
+                j += (data[j] == '\\') ? 2 : 1;
             }
-            new_str = comment_str.substr(0, 2) + new_str;
-            LOG_INFO("Rewriting multi-line comments (`/**/`) inlined in single-line comments (`//`)`: from [", new_str, "] to [",  "]");
-
-            rb_->ReplaceText(sm.getFileOffset(Comment.getBegin()), comment_str.size(), new_str);
+            i = std::min(j + 1, n);
+        }
+        else if (c == '/' && i + 1 < n && (data[i + 1] == '/' || data[i + 1] == '*'))
+        {
+            size_t j;
+            if (data[i + 1] == '*')
+            {
+                j = data.find("*/", i + 2);
+                j = (j == llvm::StringRef::npos) ? n : j + 2;
+            }
+            else // single-line comment ends at the first newline that is not escaped
+            {
+                j = i + 2;
+                while (j < n && !(data[j] == '\n' && data[j - 1] != '\\'))
+                {
+                    ++j;
+                }
+            }
+            llvm::StringRef comment = data.slice(i, j);
+            if (comment.find("/*", 2) != llvm::StringRef::npos)
+            {
+                std::string new_str = escape_nested_comment(comment);
+                LOG_INFO("Rewriting multi-line comments (`/**/`) inlined in single-line comments (`//`)`: from [",
+                         comment.str(), "] to [", new_str, "]");
+                out.reserve(n + 64);
+                out.append(data.data() + copied, i - copied);
+                out += new_str;
+                copied = j;
+            }
+            i = j;
         }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (copied == 0) // nothing to rewrite
+    {
+        return 0;
+    }
+    out.append(data.data() + copied, n - copied);
+    buffer->reset(); // release mapping before overwriting the file
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(file, ec);
+    if (ec)
+    {
+        LOG_ERROR("Failed to write [", file, "]: ", ec.message());
+        return 1;
     }
-    return false;
+    os << out;
+    return 0;
 }
 
 } // namespace rewrite
@@ -49,9 +49,17 @@ void SignalDeclRewriter::action(const VrtlParser &parser,
         LOG_VERBOSE("{signal_decl}: ", x->getNameAsString(), "\n  `\\-", get_source_code_str(x));
         LOG_VERBOSE("AST:\n", util::logging::dump_to_str(x));
 
+        // in concurrent runs, declarations are only rewritten by the run on their own header. Otherwise, runs on
+        // headers including each other would overwrite each others changes.
+        if (main_file_only_ && !srcmgr.isInMainFile(x->getLocation()))
+        {
+            return;
+        }
+
         auto target_index = get_core().is_decl_target(x);
         if (target_index >= 0)
         {
+            auto lock = get_core().lock_ctx();
             auto &t = get_core().get_target_from_index(target_index);
             if (t.check_declared_here(x))
             {
@@ -74,32 +82,14 @@ void SignalDeclRewriter::write_injection_decl(const clang::FieldDecl *decl, cons
     x << parser.getRewriter().getRewrittenText(decl->getSourceRange()) << "; ";
     x << "vrtlfi::td::";
 
-    auto cxxdim = t.get_cxx_dimension_lengths();
-    auto cxxdimtypes = t.get_cxx_dimension_types();
-
-    switch (cxxdim.size())
+    auto td_type = t.get_td_type();
+    if (td_type.empty())
     {
-    case 0:
-        x << "ZeroD_TDentry<" << t.get_cxx_type() << ">"
-          << " *" << t.get_id() << "__td_";
-        break;
-    case 1:
-        x << "OneD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ">"
-          << " *" << t.get_id() << "__td_";
-        break;
-    case 2:
-        x << "TwoD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ", " << cxxdim[1]
-          << ">"
-          << " *" << t.get_id() << "__td_";
-        break;
-    case 3:
-        x << "ThreeD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", " << cxxdim[0] << ", "
-          << cxxdim[1] << ", " << cxxdim[2] << ">"
-          << " *" << t.get_id() << "__td_";
-        break;
-    default:
         LOG_ERROR("CType dimensions of injection target not supported: ", t.get_cxx_type());
-        break;
+    }
+    else
+    {
+        x << td_type << " *" << t.get_id() << "__td_";
     }
 
     parser.getRewriter().ReplaceText(decl->getSourceRange(), x.str());
@@ -108,11 +98,9 @@ void SignalDeclRewriter::write_injection_decl(const clang::FieldDecl *decl, cons
 
 void SignalDeclRewriter::modify_includes(const clang::Decl *decl, const VrtlParser &parser) const
 {
-    static std::set<FileID> fid_set{};
-
     FileID fid = parser.getRewriter().getSourceMgr().getFileID(decl->getBeginLoc());
-    auto fid_pos = fid_set.find(fid);
-    if (fid_pos != fid_set.end())
+    auto fid_pos = modified_includes_.find(fid);
+    if (fid_pos != modified_includes_.end())
     {
         return; // already modified
     }
@@ -134,11 +122,14 @@ void SignalDeclRewriter::modify_includes(const clang::Decl *decl, const VrtlPars
             // the VRTL class definition
             parser.getRewriter().ReplaceText(flocra, newc);
         }
-        fid_set.insert(fid);
+        modified_includes_.insert(fid);
     }
 }
 
-SignalDeclRewriter::SignalDeclRewriter(const VrtlmodCore &core) : VrtlmodPass(core) {}
+SignalDeclRewriter::SignalDeclRewriter(const VrtlmodCore &core, bool main_file_only)
+    : VrtlmodPass(core), main_file_only_(main_file_only)
+{
+}
 
 void SignalDeclRewriter::analyzeRewrite(void)
 {
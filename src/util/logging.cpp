@@ -21,9 +21,14 @@
 
 #include "vrtlmod/util/logging.hpp"
 
+#include <condition_variable>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 namespace util
 {
@@ -50,47 +55,151 @@ const char *toString(LEVEL level)
     }
 }
 
+namespace detail
+{
+std::atomic<bool> silent{ false };
+std::atomic<bool> verbose{ false };
+} // namespace detail
+
+namespace
+{
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Buffers formatted messages and writes them to std::cout from a worker thread
+class AsyncSink
+{
+    std::mutex mutex_;
+    std::condition_variable pending_;
+    std::condition_variable drained_;
+    std::vector<std::string> buffer_{};
+    bool writing_{ false };
+    bool stop_{ false };
+    std::thread worker_;
+
+    void run(void)
+    {
+        std::vector<std::string> lines;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            pending_.wait(lock, [&] { return stop_ || !buffer_.empty(); });
+            if (buffer_.empty())
+            {
+                return; // stopped and drained
+            }
+            lines.swap(buffer_);
+            writing_ = true;
+            lock.unlock();
+            for (const auto &line : lines)
+            {
+                std::cout << line << '\n';
+            }
+            std::cout.flush();
+            lines.clear();
+            lock.lock();
+            writing_ = false;
+            drained_.notify_all();
+        }
+    }
+
+  public:
+    void push(std::string line)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffer_.push_back(std::move(line));
+        }
+        pending_.notify_one();
+    }
+    void flush(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_.wait(lock, [&] { return buffer_.empty() && !writing_; });
+    }
+
+    AsyncSink(void) : worker_(&AsyncSink::run, this) {}
+    ~AsyncSink(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        pending_.notify_one();
+        worker_.join();
+    }
+};
+
+std::mutex sink_mutex;             ///< guards sink and synchronous writes
+std::unique_ptr<AsyncSink> sink{}; ///< asynchronous sink, nullptr if synchronous
+} // namespace
+
 void toggle_silent(void)
 {
-    log(VERBOSE, "", true);
+    detail::silent = !detail::silent;
 }
 void toggle_verbose(void)
 {
-    log(VERBOSE, "", false, true);
+    detail::verbose = !detail::verbose;
 }
 
-void log(LEVEL level, const std::string &msg, bool silent_toggle, bool verbose_toggle)
+void set_async(bool async)
 {
-    static bool silent = false;
-    static bool verbose = false;
-    std::stringstream x;
-    if (silent_toggle)
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    if (async && !sink)
     {
-        silent = !silent;
+        sink = std::make_unique<AsyncSink>();
     }
-    if (verbose_toggle)
+    else if (!async)
     {
-        verbose = !verbose;
+        sink.reset(); // joins the worker after writing all buffered messages
     }
-    if (level == VERBOSE && !verbose)
+}
+
+void flush(void)
+{
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    if (sink)
+    {
+        sink->flush();
+    }
+    else
+    {
+        std::cout.flush();
+    }
+}
+
+void log(LEVEL level, const std::string &msg)
+{
+    if ((level == VERBOSE && !detail::verbose) || (detail::silent && level != ERROR && level != OBLIGAT))
     {
         return;
     }
 
-    if ((silent == false) || ((silent == true) && (level == ERROR or level == OBLIGAT)))
+    std::string line;
+    switch (level)
+    {
+    case ERROR:
+        [[fallthrough]];
+    case WARNING:
+        line = util::concat(toString(level), msg, " \033[0m");
+        break;
+    default:
+        line = util::concat(toString(level), " \033[0m", msg);
+        break;
+    }
+
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    if (sink)
     {
-        switch (level)
+        sink->push(std::move(line));
+        if (level == ERROR)
         {
-        case ERROR:
-            [[fallthrough]];
-        case WARNING:
-            std::cout << util::concat(toString(level), msg, " \033[0m") << std::endl;
-            break;
-        default:
-            std::cout << util::concat(toString(level), " \033[0m", msg) << std::endl;
-            break;
+            sink->flush(); // errors may precede an exception or exit
         }
     }
+    else
+    {
+        std::cout << line << std::endl;
+    }
 }
 
 template <>
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file timereport.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/util/timereport.hpp"
+#include "vrtlmod/util/logging.hpp"
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <sys/resource.h>
+#include <time.h>
+
+namespace util
+{
+
+namespace
+{
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void write_stage(llvm::json::OStream &json, const TimeReport::StageSample &stage)
+{
+    json.objectBegin();
+    json.attribute("name", stage.name_);
+    json.attribute("wall_s", stage.wall_s_);
+    json.attribute("cpu_s", stage.cpu_s_);
+    json.attribute("peak_rss_kb", static_cast<int64_t>(stage.peak_rss_kb_));
+    json.attributeArray("files",
+                        [&]
+                        {
+                            for (const auto &f : stage.files_)
+                            {
+                                json.object(
+                                    [&]
+                                    {
+                                        json.attribute("file", f.file_);
+                                        json.attribute("wall_s", f.wall_s_);
+                                        json.attribute("cpu_s", f.cpu_s_);
+                                    });
+                            }
+                        });
+    json.attributeObject("matches",
+                         [&]
+                         {
+                             for (const auto &it : stage.matches_)
+                             {
+                                 json.attribute(it.first, static_cast<int64_t>(it.second));
+                             }
+                         });
+    json.objectEnd();
+}
+} // namespace
+
+TimeReport &TimeReport::get(void)
+{
+    static TimeReport report;
+    return report;
+}
+
+double TimeReport::process_cpu_s(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+double TimeReport::thread_cpu_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+long TimeReport::peak_rss_kb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // KiB on Linux
+}
+
+void TimeReport::enable(void)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    start_ = std::chrono::steady_clock::now();
+    enabled_ = true;
+}
+
+void TimeReport::add_matches(const std::map<std::string, size_t> &matches)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_ < 0)
+    {
+        return;
+    }
+    auto &stage = stages_[current_];
+    for (const auto &it : matches)
+    {
+        stage.matches_[it.first] += it.second;
+    }
+}
+
+TimeReport::Stage::Stage(const std::string &name)
+{
+    auto &report = TimeReport::get();
+    if (!report.is_enabled())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(report.mutex_);
+        index_ = report.stages_.size();
+        report.stages_.push_back({ name, 0.0, 0.0, 0, {}, {} });
+        report.current_ = index_;
+    }
+    cpu_s_ = process_cpu_s();
+    wall_ = std::chrono::steady_clock::now();
+}
+
+TimeReport::Stage::~Stage(void)
+{
+    if (index_ < 0)
+    {
+        return;
+    }
+    auto &report = TimeReport::get();
+    double wall_s = seconds_since(wall_);
+    double cpu_s = process_cpu_s() - cpu_s_;
+    std::lock_guard<std::mutex> lock(report.mutex_);
+    auto &stage = report.stages_[index_];
+    stage.wall_s_ = wall_s;
+    stage.cpu_s_ = cpu_s;
+    stage.peak_rss_kb_ = peak_rss_kb();
+    report.current_ = -1;
+}
+
+TimeReport::File::File(const std::string &file)
+{
+    if (!TimeReport::get().is_enabled())
+    {
+        return;
+    }
+    file_ = file;
+    cpu_s_ = thread_cpu_s();
+    wall_ = std::chrono::steady_clock::now();
+}
+
+TimeReport::File::~File(void)
+{
+    if (file_.empty())
+    {
+        return;
+    }
+    auto &report = TimeReport::get();
+    FileSample sample{ file_, seconds_since(wall_), thread_cpu_s() - cpu_s_ };
+    std::lock_guard<std::mutex> lock(report.mutex_);
+    if (report.current_ >= 0)
+    {
+        report.stages_[report.current_].files_.push_back(std::move(sample));
+    }
+}
+
+TimeReport::Writer::Writer(const fs::path &file) : file_(file)
+{
+    if (!file_.empty())
+    {
+        TimeReport::get().enable();
+    }
+}
+
+TimeReport::Writer::~Writer(void)
+{
+    if (!file_.empty())
+    {
+        TimeReport::get().write(file_);
+    }
+}
+
+bool TimeReport::write(const fs::path &file) const
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(file.string(), ec);
+    if (ec)
+    {
+        LOG_ERROR("Could not open time report [", file.string(), "] for writing: ", ec.message());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    llvm::json::OStream json(os, 2);
+    json.objectBegin();
+    json.attribute("version", VRTLMOD_VERSION);
+    json.attributeObject("total",
+                         [&]
+                         {
+                             json.attribute("wall_s", seconds_since(start_));
+                             json.attribute("cpu_s", process_cpu_s());
+                             json.attribute("peak_rss_kb", static_cast<int64_t>(peak_rss_kb()));
+                         });
+    json.attributeArray("stages",
+                        [&]
+                        {
+                            for (const auto &stage : stages_)
+                            {
+                                write_stage(json, stage);
+                            }
+                        });
+    json.objectEnd();
+    os << "\n";
+    LOG_INFO("Wrote time report: ", file.string());
+    return true;
+}
+
+} // namespace util
@@ -21,6 +21,8 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "vrtlmod/util/utility.hpp"
 #include "vrtlmod/util/logging.hpp"
@@ -65,6 +67,14 @@ void replaceAll(std::string &str, const std::string &from, const std::string &to
     }
 }
 
+const std::string &intern(const std::string &str)
+{
+    static std::unordered_set<std::string> pool;
+    static std::mutex pool_mutex;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return *pool.insert(str).first; // node-based, i.e., references stay valid on rehash
+}
+
 } // namespace strhelp
 
 namespace system
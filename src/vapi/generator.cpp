@@ -72,6 +72,26 @@ std::string VapiGenerator::get_apisource_filename(void) const
 
     return util::concat(top_name, "_", API_SOURCE_NAME);
 }
+std::string VapiGenerator::get_apisource_shard_filename(unsigned shard) const
+{
+    std::string ret = get_apisource_filename();
+    return util::concat(ret.substr(0, ret.rfind(".cpp")), "_", std::to_string(shard), ".cpp");
+}
+std::string VapiGenerator::get_td_instances_header_filename(void) const
+{
+    std::string top_name = get_core().get_top_cell().get_type();
+#if VRTLMOD_VERILATOR_VERSION <= 4204
+    // nothing to do here
+#else // VRTLMOD_VERILATOR_VERSION <= 4228
+    util::strhelp::replace(top_name, "___024root", "");
+#endif
+    return util::concat(top_name, "_td_instances.hpp");
+}
+std::string VapiGenerator::get_td_instances_source_filename(void) const
+{
+    std::string ret = get_td_instances_header_filename();
+    return util::concat(ret.substr(0, ret.rfind(".hpp")), ".cpp");
+}
 
 int VapiGenerator::build_targetdictionary(void) const
 {
@@ -84,7 +104,30 @@ int VapiGenerator::build_targetdictionary(void) const
     return 0;
 }
 
-int VapiGenerator::build_api(void) const
+void VapiGenerator::remove_stale_shards(const fs::path &api_dir) const
+{
+    // shards of a previous run with more shards would otherwise be compiled along with this API
+    const unsigned shards = api_shards_ > 1 ? api_shards_ : 0;
+    std::string prefix = get_apisource_filename();
+    prefix = util::concat(prefix.substr(0, prefix.rfind(".cpp")), "_");
+    for (const auto &it : fs::directory_iterator(api_dir))
+    {
+        const std::string name = it.path().filename().string();
+        if (name.size() <= prefix.size() + 4 || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - 4, 4, ".cpp") != 0)
+        {
+            continue;
+        }
+        const std::string index = name.substr(prefix.size(), name.size() - prefix.size() - 4);
+        if (index.find_first_not_of("0123456789") == std::string::npos && std::stoul(index) >= shards)
+        {
+            LOG_INFO("Removing stale API shard [", it.path().string(), "]");
+            fs::remove(it.path());
+        }
+    }
+}
+
+int VapiGenerator::build_api(void)
 {
     auto api_dir = API_DIRPREFIX != "" ? get_core().get_output_dir() / API_DIRPREFIX : get_core().get_output_dir();
 
@@ -92,8 +135,22 @@ int VapiGenerator::build_api(void) const
     {
         fs::create_directory(fs::path(api_dir));
     }
+    collect_entries();
     vapisrc_.write(api_dir / get_apisource_filename());
+    if (api_shards_ > 1)
+    {
+        for (unsigned i = 0; i < api_shards_; ++i)
+        {
+            VapiSourceShard(*this, i).write(api_dir / get_apisource_shard_filename(i));
+        }
+    }
+    remove_stale_shards(api_dir);
     vapiheader_.write(api_dir / get_apiheader_filename());
+    if (get_core().has_td_instances())
+    {
+        tdinstancesheader_.write(api_dir / get_td_instances_header_filename());
+        tdinstancessrc_.write(api_dir / get_td_instances_source_filename());
+    }
 
     unsigned int failed = get_core().get_ctx().toinj_targets_.size();
 
@@ -30,6 +30,7 @@
 #include <verilated.h>
 
 #include <map>
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 
@@ -1159,6 +1160,139 @@ std::vector<int> ThreeD_TDentry<vcontainer_t, vbasetype_t, K, L, M>::get_cntr(vo
                 c.push_back(cntr_[k][l][m]);
     return c;
 }
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @class CompareDescriptor
+/// @brief The contiguous elements of a target in the faulty, reference, and differential model, compared by
+///        diff_table and compare_table instead of per-element unrolled code
+struct CompareDescriptor
+{
+    const TDentry *target_;   ///< entry of the faulty model, returned on mismatch
+    const void *faulty_;      ///< first element in the faulty model
+    const void *reference_;   ///< first element in the reference model
+    void *diff_;              ///< first element in the differential model
+    size_t elements_;         ///< number of elements
+    unsigned stride_;         ///< size of an element in bytes, i.e., 1, 2, 4, or 8
+    uint64_t mask_;           ///< mask of an element, or of a fully used word of a wide element
+    uint64_t last_word_mask_; ///< mask of the last word of a wide element
+    size_t words_;            ///< number of words of a wide element, 1 otherwise
+};
+
+template <typename word_t>
+inline int __diff_elements(const CompareDescriptor &d)
+{
+    const word_t *lhs = static_cast<const word_t *>(d.faulty_);
+    const word_t *rhs = static_cast<const word_t *>(d.reference_);
+    word_t *diff = static_cast<word_t *>(d.diff_);
+    const word_t mask = d.mask_;
+    int ret = 0;
+    for (size_t i = 0; i < d.elements_; ++i)
+    {
+        diff[i] = (lhs[i] ^ rhs[i]) & mask;
+        ret += diff[i] ? 1 : 0;
+    }
+    if (d.words_ > 1 && d.last_word_mask_ != d.mask_)
+    {
+        const word_t last_word_mask = d.last_word_mask_;
+        for (size_t i = d.words_ - 1; i < d.elements_; i += d.words_)
+        {
+            ret -= (diff[i] && !(diff[i] & last_word_mask)) ? 1 : 0;
+            diff[i] &= last_word_mask;
+        }
+    }
+    return ret;
+}
+
+template <typename word_t>
+inline bool __compare_elements(const CompareDescriptor &d)
+{
+    const word_t *lhs = static_cast<const word_t *>(d.faulty_);
+    const word_t *rhs = static_cast<const word_t *>(d.reference_);
+    const word_t mask = d.mask_;
+    word_t acc = 0;
+    for (size_t i = 0; i < d.elements_; ++i)
+    {
+        acc |= (lhs[i] ^ rhs[i]) & mask;
+    }
+    if (__LIKELY(!acc) || d.words_ == 1 || d.last_word_mask_ == d.mask_)
+    {
+        return acc != 0;
+    }
+    // some mismatch, ignore the unused bits of the last words
+    const word_t last_word_mask = d.last_word_mask_;
+    for (size_t i = 0; i < d.elements_; ++i)
+    {
+        if ((lhs[i] ^ rhs[i]) & (((i + 1) % d.words_ == 0) ? last_word_mask : mask))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Stores the masked XOR of faulty and reference elements of all descriptors in the differential model
+/// \return count of mismatching elements
+inline int diff_table(const std::vector<CompareDescriptor> &table)
+{
+    int ret = 0;
+    for (const auto &d : table)
+    {
+        switch (d.stride_)
+        {
+        case 1:
+            ret += __diff_elements<uint8_t>(d);
+            break;
+        case 2:
+            ret += __diff_elements<uint16_t>(d);
+            break;
+        case 4:
+            ret += __diff_elements<uint32_t>(d);
+            break;
+        case 8:
+            ret += __diff_elements<uint64_t>(d);
+            break;
+        default:
+            throw std::invalid_argument("unsupported compare descriptor stride");
+        }
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compares faulty and reference elements of the descriptors, beginning at `start` and wrapping around
+/// \return Target of the first mismatching descriptor, nullptr if none mismatches
+inline const TDentry *compare_table(const std::vector<CompareDescriptor> &table, size_t start = 0)
+{
+    start = (start < table.size()) ? start : 0;
+    for (size_t n = 0; n < table.size(); ++n)
+    {
+        const auto &d = table[(start + n < table.size()) ? start + n : start + n - table.size()];
+        bool mismatch;
+        switch (d.stride_)
+        {
+        case 1:
+            mismatch = __compare_elements<uint8_t>(d);
+            break;
+        case 2:
+            mismatch = __compare_elements<uint16_t>(d);
+            break;
+        case 4:
+            mismatch = __compare_elements<uint32_t>(d);
+            break;
+        case 8:
+            mismatch = __compare_elements<uint64_t>(d);
+            break;
+        default:
+            throw std::invalid_argument("unsupported compare descriptor stride");
+        }
+        if (__UNLIKELY(mismatch))
+        {
+            return d.target_;
+        }
+    }
+    return nullptr;
+}
+
 } // namespace td
 
 } // namespace vrtlfi
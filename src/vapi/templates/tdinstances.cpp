@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 Chair of EDA, Technical University of Munich
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *	 http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file tdinstances.cpp
+/// @brief Explicit instantiations of the target dictionary entry types. Without them, every instrumented VRTL source
+/// instantiates all (virtual) members of the entry types of the targets it uses
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vrtlmod/vapi/generator.hpp"
+#include "vrtlmod/core/core.hpp"
+#include "vrtlmod/core/types.hpp"
+
+namespace vrtlmod
+{
+namespace vapi
+{
+
+std::set<std::string> VapiGenerator::get_td_instances(void) const
+{
+    std::set<std::string> ret;
+    get_core().foreach_injection_target(
+        [&](const types::Target &t)
+        {
+            auto td_type = t.get_td_type();
+            if (!td_type.empty() && t.get_cxx_type().find("sc_") == std::string::npos)
+            {
+                ret.insert(td_type);
+                ret.insert(util::concat("Named_TDentry<", t.get_cxx_type(), ">"));
+            }
+            return true;
+        });
+    return ret;
+}
+
+std::string VapiGenerator::TDInstancesHeader::generate_body(void) const
+{
+    std::string header = gen_.get_td_instances_header_filename();
+    std::string guard = util::concat("__", header.substr(0, header.rfind("_td_instances.hpp")), "_TD_INSTANCES_HPP__");
+
+    std::stringstream x;
+    x << "#ifndef " << guard << "\n#define " << guard << R"(
+
+#include ")" << gen_.get_targetdictionary_relpath()
+      << R"("
+
+// defined in )"
+      << gen_.get_td_instances_source_filename() << "\n";
+    for (const auto &it : gen_.get_td_instances())
+    {
+        x << "extern template class vrtlfi::td::" << it << ";\n";
+    }
+    x << "\n#endif /* " << guard << " */\n";
+    return x.str();
+}
+
+std::string VapiGenerator::TDInstancesSource::generate_body(void) const
+{
+    std::stringstream x;
+    x << R"(#include ")" << gen_.get_td_instances_header_filename() << R"("
+
+)";
+    for (const auto &it : gen_.get_td_instances())
+    {
+        x << "template class vrtlfi::td::" << it << ";\n";
+    }
+    return x.str();
+}
+
+} // namespace vapi
+} // namespace vrtlmod
@@ -68,8 +68,14 @@ struct )"
       << "    void operator=(" << api_name << R"( const&) = delete;
 )"
       << "    " << top_type << R"( vrtl_;
-)"
-      << R"(};
+)";
+    const unsigned shards = gen_.get_api_shards();
+    for (unsigned i = 0; (shards > 1) && (i < shards); ++i)
+    {
+        x << "    void init_td_shard_" << i << "(void); ///< defined in " << gen_.get_apisource_shard_filename(i)
+          << "\n";
+    }
+    x << R"(};
 
 class )"
 
@@ -81,7 +87,33 @@ class )"
     /// \brief Get link id for passed target which can be a pointer to an element
     ///        of either `faulty_`, `reference_`, or `this`
     size_t get_id(vrtlfi::td::TDentry const *target) const;
+    /////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the targets of `this` ordered by name, i.e., independent of
+    ///        their addresses in `diff_target2id_`
+    std::vector<vrtlfi::td::TDentry const*> get_diff_targets(void) const;
+)";
+    for (unsigned i = 0; (shards > 1) && (i < shards); ++i)
+    {
+        x << R"(
+    // defined in )" << gen_.get_apisource_shard_filename(i)
+          << R"(
+    void init_target2id_shard_)"
+          << i << R"((void);
 )";
+        if (!gen_.get_compare_table())
+        {
+            x << R"(    int diff_target_dictionaries_shard_)" << i << R"((void);
+    vrtlfi::td::TDentry const* compare_fast_shard_)"
+              << i << R"((size_t id) const;
+)";
+        }
+    }
+    if (gen_.get_compare_table())
+    {
+        x << R"(
+    std::vector<vrtlfi::td::CompareDescriptor> compare_table_; ///< compared elements of all targets by id
+)";
+    }
     if (core.is_systemc())
     {
         if (auto top_module = core.get_module_from_cell(core.get_top_cell()))
@@ -24,8 +24,17 @@
 #include "vrtlmod/core/types.hpp"
 #include "vrtlmod/util/logging.hpp"
 
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+
 #include <boost/algorithm/string/replace.hpp>
 
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <unordered_map>
+
 namespace vrtlmod
 {
 namespace vapi
@@ -37,43 +46,393 @@ static const char *SYMBOLTABLE_NAME =
     "vlSymsp";
 #endif
 
-std::string VapiGenerator::VapiSource::generate_body(void) const
+namespace
 {
-    int td_nmb = 0;
-    bool fast_compare = false;
 
-    const auto &core = gen_.get_core();
+using TargetEntry = VapiGenerator::TargetEntry;
+
+std::string get_api_name(const VrtlmodCore &core)
+{
     std::string top_name = core.get_top_cell().get_type();
 #if VRTLMOD_VERILATOR_VERSION <= 4204
 #else // VRTLMOD_VERILATOR_VERSION <= 4228
     util::strhelp::replace(top_name, "___024root", "");
 #endif
-    std::string top_type = top_name;
-
-    std::stringstream x, entries;
+    return top_name + "VRTLmodAPI";
+}
 
-    std::string api_name = top_type + "VRTLmodAPI";
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Splits the entries into `shards` consecutive ranges of about the same number of elements
+/// @return `shards + 1` range boundaries, i.e., shard `i` holds the entries [ret[i], ret[i+1])
+std::vector<size_t> balance_shards(const std::vector<TargetEntry> &entries, unsigned shards)
+{
+    size_t total = 0;
+    for (const auto &e : entries)
+    {
+        total += e.elements_;
+    }
+    std::vector<size_t> ret{ 0 };
+    size_t sum = 0;
+    for (size_t i = 0; i < entries.size() && ret.size() < shards; ++i)
+    {
+        sum += entries[i].elements_;
+        if (sum * shards >= total * ret.size())
+        {
+            ret.push_back(i + 1);
+        }
+    }
+    while (ret.size() <= shards)
+    {
+        ret.push_back(entries.size());
+    }
+    return ret;
+}
 
+std::string get_includes(const VapiGenerator &gen)
+{
+    const auto &core = gen.get_core();
+    std::stringstream x;
     x << R"(// Vrtl-specific includes:
 #include ")"
       << core.get_vrtltopheader_filename() << R"("
 #include ")"
       << core.get_vrtltopsymsheader_filename() << R"("
 // General API includes:
+#include <algorithm>
 #include <memory>
 #include <iostream>
 #include "verilated.h"
 #include ")"
-      << gen_.get_targetdictionary_relpath() << R"("
+      << gen.get_targetdictionary_relpath() << R"("
 #include ")"
-      << gen_.get_apiheader_filename() << R"("
+      << gen.get_apiheader_filename() << R"("
 
-)" << api_name
-      << "::" << api_name << R"((const char* name)
-    : vrtlfi::td::TD_API()
-    , vrtl_(name)
+)";
+    return x.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the target dictionary initialization of the entries [begin, end)
+void write_init_td(std::ostream &x, const std::vector<TargetEntry> &entries, size_t begin, size_t end)
 {
+    for (size_t id = begin; id < end; ++id)
+    {
+        const auto &t = *entries[id].t_;
+        const auto &prefix_str = entries[id].prefix_;
+        std::stringstream smart_type, initializer;
+        auto member_str = util::concat("vrtl_.", entries[id].member_);
+
+        std::string map_key = util::concat(prefix_str, ".", t.get_id());
+
+        smart_type << "vrtlfi::td::";
+
+        const auto &layout = t.get_layout();
+        auto td_type = t.get_td_type();
+        if (td_type.empty())
+        {
+            LOG_ERROR("CType dimensions of injection target not supported: ", t.get_cxx_type());
+        }
+        else
+        {
+            smart_type << td_type;
+            initializer << "(\"" << prefix_str << "." << t.get_id() << "\", " << member_str << ", " << layout.bits_
+                        << ", " << layout.one_dim_bits_ << ")";
+        }
+        x << "    td_[ \"" << map_key << "\" ]"
+          << " = "
+          << "std::make_shared< " << smart_type.str() << " >" << initializer.str() << ";\n";
+        x << "    " << member_str << "__td_"
+          << " = std::static_pointer_cast< " << smart_type.str() << ">(td_.at(\"" << map_key << "\")).get();\n\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the target to id links of the Differential for the entries [begin, end)
+void write_target2id(std::ostream &x, const std::vector<TargetEntry> &entries, size_t begin, size_t end)
+{
+    for (size_t id = begin; id < end; ++id)
+    {
+        const auto &t = *entries[id].t_;
+        const auto &prefix_str = entries[id].prefix_;
+
+        x << R"(
+    // )" << prefix_str
+          << "." << t.get_id() << ":"
+          << R"(
+    faulty_target2id_[faulty_.get_target)"
+          << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << id << R"(;
+    reference_target2id_[reference_.get_target)"
+          << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << id << R"(;
+    diff_target2id_[get_target)"
+          << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << id << R"(;
 )";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the compare descriptors (vrtlfi::td::CompareDescriptor) of the entries [begin, end) into the
+/// Differential's table, i.e., one per target instead of one compare per element
+void write_compare_descriptors(std::ostream &x, const std::vector<TargetEntry> &entries, size_t begin, size_t end)
+{
+    for (size_t id = begin; id < end; ++id)
+    {
+        const auto &t = *entries[id].t_;
+        const auto &prefix_str = entries[id].prefix_;
+        const auto &member_str = entries[id].member_;
+        const auto &layout = t.get_layout();
+
+        x << "    compare_table_.push_back({ faulty_.td_.at(\"" << prefix_str << "." << t.get_id() << "\").get(), "
+          << "&faulty_.vrtl_." << member_str << ", &reference_.vrtl_." << member_str << ", &this->vrtl_."
+          << member_str << ", " << layout.element_count_ << ", sizeof(" << layout.cxx_dim_types_.back() << "), 0x"
+          << std::hex << layout.element_mask_ << ", 0x" << layout.last_word_mask_ << std::dec << ", "
+          << layout.words_ << " });\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the unrolled compare of the entries [begin, end), either the diff into the Differential's target
+/// dictionary or, for `fast_compare`, the fall-through switch cases returning the first mismatch
+void write_compare(std::ostream &x, const std::vector<TargetEntry> &entries, size_t begin, size_t end,
+                   bool fast_compare)
+{
+    for (size_t id = begin; id < end; ++id)
+    {
+        const auto &t = *entries[id].t_;
+        const auto &prefix_str = entries[id].prefix_;
+        const auto &member_str = entries[id].member_;
+
+        const auto &layout = t.get_layout();
+        const auto &cxxdim = layout.cxx_dim_lengths_;
+
+        auto lhs_str = "faulty_.vrtl_." + member_str;
+        auto rhs_str = "reference_.vrtl_." + member_str;
+        auto xor_str = "this->vrtl_." + member_str;
+
+        if (!fast_compare)
+        {
+            x << R"(
+    )";
+        }
+        else
+        {
+            x << R"(
+        case )" << id << ": ";
+        }
+        x << "// )" << prefix_str << "." << t.get_id() << ":";
+
+        switch (cxxdim.size())
+        {
+        case 0:
+        {
+            if (!fast_compare)
+            {
+                x << R"(
+    )" << xor_str << " = (" << lhs_str
+                  << " ^ " << rhs_str << ") & 0x" << std::hex << layout.get_element_mask({}) << std::dec << ";";
+                x << R"(
+    ret += )" << xor_str << "? 1 : 0;";
+            }
+            else
+            {
+                x << R"(
+            if(__UNLIKELY(()" << lhs_str
+                  << " ^ " << rhs_str << ") & 0x" << std::hex << layout.get_element_mask({}) << std::dec << "))"
+                  << R"(
+                return faulty_.td_.at)"
+                  << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
+            }
+        }
+        break;
+        case 1:
+        {
+            for (size_t m = 0; m < cxxdim[0]; ++m)
+            {
+                if (!fast_compare)
+                {
+                    x << R"(
+    )" << xor_str << "[" << m << "]"
+                      << " = (" << lhs_str << "[" << m << "]"
+                      << " ^ " << rhs_str << "[" << m << "])"
+                      << " & 0x" << std::hex << layout.get_element_mask({ m }) << std::dec << ";";
+                    x << R"(
+                                        ret += )"
+                      << xor_str << "[" << m << "] ? 1 : 0;";
+                }
+                else
+                {
+                    x << R"(
+            if(__UNLIKELY(()" << lhs_str
+                      << "[" << m << "]"
+                      << " ^ " << rhs_str << "[" << m << "]) & 0x" << std::hex << layout.get_element_mask({ m })
+                      << std::dec << "))"
+                      << R"(
+                return faulty_.td_.at)"
+                      << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
+                }
+            }
+        }
+        break;
+        case 2:
+        {
+            for (size_t l = 0; l < cxxdim[1]; ++l)
+                for (size_t m = 0; m < cxxdim[0]; ++m)
+                {
+                    if (!fast_compare)
+                    {
+                        x << R"(
+    )" << xor_str << "[" << m << "]"
+                          << "[" << l << "]"
+                          << " = (" << lhs_str << "[" << m << "]"
+                          << "[" << l << "]"
+                          << " ^ " << rhs_str << "[" << m << "]"
+                          << "[" << l << "]) & 0x" << std::hex << layout.get_element_mask({ l, m }) << std::dec
+                          << ";";
+                        x << R"(
+    ret += )" << xor_str << "[" << m << "]"
+                          << "[" << l << "] ? 1 : 0;";
+                    }
+                    else
+                    {
+                        x << R"(
+            if(__UNLIKELY(()" << lhs_str
+                          << "[" << m << "]"
+                          << "[" << l << "]"
+                          << " ^ " << rhs_str << "[" << m << "]"
+                          << "[" << l << "]) & 0x" << std::hex << layout.get_element_mask({ l, m }) << std::dec
+                          << " ))"
+                          << R"(
+                return faulty_.td_.at)"
+                          << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
+                    }
+                }
+        }
+        break;
+        case 3:
+        {
+            for (size_t k = 0; k < cxxdim[2]; ++k)
+                for (size_t l = 0; l < cxxdim[1]; ++l)
+                    for (size_t m = 0; m < cxxdim[0]; ++m)
+                    {
+                        if (!fast_compare)
+                        {
+                            x << R"(
+    )" << xor_str << "[" << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "]"
+                              << " = (" << lhs_str << "[" << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "]"
+                              << " ^ " << rhs_str << "[" << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "]) & 0x" << std::hex << layout.get_element_mask({ k, l, m })
+                              << std::dec << ";";
+                            x << R"(
+    ret += )" << xor_str << "[" << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "] ? 1 : 0;";
+                        }
+                        else
+                        {
+                            x << R"(
+            if(__UNLIKELY(()" << lhs_str << "["
+                              << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "]"
+                              << " ^ " << rhs_str << "[" << m << "]"
+                              << "[" << l << "]"
+                              << "[" << k << "]) & 0x" << std::hex << layout.get_element_mask({ k, l, m })
+                              << std::dec << "))"
+                              << R"(
+                return faulty_.td_.at)"
+                              << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
+                        }
+                    }
+        }
+        break;
+        default:
+            LOG_ERROR("CType dimensions of injection target not supported: ", t.get_cxx_type());
+            break;
+        }
+        if (fast_compare)
+        {
+            x << R"(
+        [[ fallthrough ]];)";
+        }
+        x << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the entries [begin, end) with `writer`. With more than one job, the range is split into chunks of
+/// about CHUNK_ELEMENTS compared elements that are generated in parallel and written in order, at most two chunks per
+/// thread are buffered. Failures (LOG_FATAL) of `writer` are rethrown on the calling thread
+void write_chunked(std::ostream &os, const std::vector<TargetEntry> &entries, size_t begin, size_t end, unsigned jobs,
+                   const std::function<void(std::ostream &, size_t, size_t)> &writer)
+{
+    constexpr size_t CHUNK_ELEMENTS = 4096;
+    if (jobs == 1)
+    {
+        writer(os, begin, end);
+        return;
+    }
+
+    std::vector<size_t> chunks{ begin };
+    size_t elements = 0;
+    for (size_t id = begin; id < end; ++id)
+    {
+        elements += entries[id].elements_;
+        if (elements >= CHUNK_ELEMENTS || id + 1 == end)
+        {
+            chunks.push_back(id + 1);
+            elements = 0;
+        }
+    }
+
+    // llvm::ThreadPool does not catch exceptions of its tasks, they are passed with the generated code instead
+    struct Chunk
+    {
+        std::string code_;
+        std::exception_ptr except_;
+    };
+
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+    std::deque<std::shared_future<Chunk>> pending;
+    for (size_t next = 0; (next + 1 < chunks.size()) || !pending.empty();)
+    {
+        while ((next + 1 < chunks.size()) && (pending.size() < 2 * pool.getThreadCount()))
+        {
+            pending.push_back(pool.async(
+                [&writer, chunk_begin = chunks[next], chunk_end = chunks[next + 1]]() -> Chunk
+                {
+                    try
+                    {
+                        std::stringstream x;
+                        writer(x, chunk_begin, chunk_end);
+                        return { x.str(), nullptr };
+                    }
+                    catch (...)
+                    {
+                        return { "", std::current_exception() };
+                    }
+                }));
+            ++next;
+        }
+        const Chunk &chunk = pending.front().get();
+        if (chunk.except_)
+        {
+            std::rethrow_exception(chunk.except_);
+        }
+        os << chunk.code_;
+        pending.pop_front();
+    }
+}
+
+} // namespace
+
+void VapiGenerator::collect_entries(void)
+{
+    const auto &core = get_core();
+    entries_.clear();
 
     auto get_prefix = [&](types::Cell const *c, std::string module_instance) -> std::string
     {
@@ -95,92 +454,85 @@ std::string VapiGenerator::VapiSource::generate_body(void) const
             , t.get_id());
     };
 
-    auto write_init_td = [&](const types::Module &M) -> bool
-    {
-        types::Module const *m = &M;
-        types::Cell const *c = nullptr;
-
-        auto celliter = [&](const types::Cell &C) -> bool
+    // a cell of each module, i.e., the top cell for the top module (visited first), any instance otherwise
+    std::unordered_map<const types::Module *, const types::Cell *> module_cells;
+    core.foreach_cell(
+        [&](const types::Cell &c)
         {
-            if (m == core.get_module_from_cell(C))
-            {
-                c = &C;
-                return false;
-            }
+            module_cells.emplace(core.get_module_from_cell(c), &c);
             return true;
-        };
-        core.foreach_cell(celliter);
+        });
+    // injection targets by declaring module, in the order of foreach_injection_target
+    std::unordered_map<const types::Module *, std::vector<const types::Target *>> module_targets;
+    core.foreach_injection_target(
+        [&](const types::Target &t)
+        {
+            module_targets[&t.get_parent()].push_back(&t);
+            return true;
+        });
 
-        if (c == nullptr)
+    auto moduleiterf = [&](const types::Module &M) -> bool
+    {
+        auto c = module_cells.find(&M);
+        if (c == module_cells.end())
         {
-            LOG_FATAL("Can not find parent Cell of Module ", m->get_id(), " [", m->get_name(), "]");
+            LOG_FATAL("Can not find parent Cell of Module ", M.get_id(), " [", M.get_name(), "]");
         }
-
-        auto targetiterf = [&](const types::Target &t) -> bool
+        auto targets = module_targets.find(&M);
+        if (targets == module_targets.end())
+        {
+            return true;
+        }
+        for (const auto *t : targets->second)
         {
-            if (t.get_parent() == *m)
+            size_t elements = 1;
+            for (auto length : t->get_layout().cxx_dim_lengths_)
             {
-                for (const auto &module_instance : t.get_parent().symboltable_instances_)
-                {
-                    std::stringstream smart_type, initializer;
-                    std::string type_str, initializer_str;
-                    auto prefix_str = get_prefix(c, module_instance);
-                    auto member_str = util::concat("vrtl_.", get_memberstr(c, t, prefix_str));
-
-                    std::string map_key = util::concat(prefix_str, ".", t.get_id());
+                elements *= length;
+            }
+            for (const auto &module_instance : M.symboltable_instances_)
+            {
+                auto prefix_str = get_prefix(c->second, module_instance);
+                entries_.push_back({ t, prefix_str, get_memberstr(c->second, *t, prefix_str), elements });
+            }
+        }
+        return true;
+    };
+    core.foreach_module(moduleiterf);
 
-                    smart_type << "vrtlfi::td::";
+    shard_bounds_ = balance_shards(entries_, api_shards_);
+}
 
-                    auto cxxdim = t.get_cxx_dimension_lengths();
-                    auto one_dim_bits = t.get_one_dim_bits();
-                    auto cxxdimtypes = t.get_cxx_dimension_types();
+void VapiGenerator::VapiSource::write_body(std::ostream &x) const
+{
+    const auto &core = gen_.get_core();
+    const unsigned shards = gen_.get_api_shards();
+    const unsigned jobs = gen_.get_jobs();
+    const bool compare_table = gen_.get_compare_table();
+    const auto &entries = gen_.get_entries();
+    const auto &bounds = gen_.get_shard_bounds();
 
-                    switch (cxxdim.size())
-                    {
-                    case 0:
-                        smart_type << "ZeroD_TDentry<" << t.get_cxx_type() << ">";
-                        initializer << "(\"" << prefix_str << "." << t.get_id() << "\", " << member_str << ", "
-                                    << t.get_bits() << ", " << one_dim_bits << ")";
-                        break;
-                    case 1:
-                        smart_type << "OneD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", "
-                                   << cxxdim[0] << ">";
-                        initializer << "(\"" << prefix_str << "." << t.get_id() << "\", " << member_str << ", "
-                                    << t.get_bits() << ", " << one_dim_bits << ")";
-                        break;
-                    case 2:
-                        smart_type << "TwoD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", "
-                                   << cxxdim[0] << ", " << cxxdim[1] << ">";
-                        initializer << "(\"" << prefix_str << "." << t.get_id() << "\", " << member_str << ", "
-                                    << t.get_bits() << ", " << one_dim_bits << ")";
-                        break;
-                    case 3:
-                        smart_type << "ThreeD_TDentry<" << t.get_cxx_type() << ", " << cxxdimtypes.back() << ", "
-                                   << cxxdim[0] << ", " << cxxdim[1] << ", " << cxxdim[2] << ">";
-                        initializer << "(\"" << prefix_str << "." << t.get_id() << "\", " << member_str << ", "
-                                    << t.get_bits() << ", " << one_dim_bits << ")";
-                        break;
-                    default:
-                        LOG_ERROR("CType dimensions of injection target not supported: ", t.get_cxx_type());
-                        break;
-                    }
-                    x << "    td_[ \"" << map_key << "\" ]"
-                      << " = "
-                      << "std::make_shared< " << smart_type.str() << " >" << initializer.str() << ";\n";
-                    x << "    " << member_str << "__td_"
-                      << " = std::static_pointer_cast< " << smart_type.str() << ">(td_.at(\"" << map_key
-                      << "\")).get();\n\n";
-                }
-            }
-            return true;
-        };
-        core.foreach_injection_target(targetiterf);
+    std::string api_name = get_api_name(core);
+    std::string top_type = api_name.substr(0, api_name.size() - std::string("VRTLmodAPI").size());
 
-        return true;
-    };
+    x << get_includes(gen_) << api_name << "::" << api_name << R"((const char* name)
+    : vrtlfi::td::TD_API()
+    , vrtl_(name)
+{
+)";
 
-    td_nmb = 0;
-    core.foreach_module(write_init_td);
+    if (shards == 1)
+    {
+        write_chunked(x, entries, 0, entries.size(), jobs,
+                      [&](std::ostream &os, size_t begin, size_t end) { write_init_td(os, entries, begin, end); });
+    }
+    else
+    {
+        for (unsigned i = 0; i < shards; ++i)
+        {
+            x << "    init_td_shard_" << i << "();\n";
+        }
+    }
 
     x << "}" << std::endl;
     x << top_type << "VRTLmodAPI::~" << top_type << "VRTLmodAPI(void) { \n\
@@ -218,263 +570,35 @@ std::string VapiGenerator::VapiSource::generate_body(void) const
         }
     }
 
-    auto writetarget2idinit = [&](const types::Module &M) -> bool
+    if (compare_table)
     {
-        types::Module const *m = &M;
-        types::Cell const *c = nullptr;
-
-        auto celliter = [&](const types::Cell &C) -> bool
-        {
-            if (m == core.get_module_from_cell(C))
-            {
-                c = &C;
-                return false;
-            }
-            return true;
-        };
-        core.foreach_cell(celliter);
-
-        if (c == nullptr)
+        x << R"(
+    compare_table_.reserve()"
+          << entries.size() << ");\n";
+    }
+    if (shards == 1)
+    {
+        write_chunked(x, entries, 0, entries.size(), jobs,
+                      [&](std::ostream &os, size_t begin, size_t end) { write_target2id(os, entries, begin, end); });
+        if (compare_table)
         {
-            LOG_FATAL("Can not find parent Cell of Module ", m->get_id(), " [", m->get_name(), "]");
+            write_chunked(x, entries, 0, entries.size(), jobs, [&](std::ostream &os, size_t begin, size_t end)
+                          { write_compare_descriptors(os, entries, begin, end); });
         }
-
-        auto targetiterf = [&](const types::Target &t) -> bool
+    }
+    else
+    {
+        for (unsigned i = 0; i < shards; ++i)
         {
-            if (t.get_parent() == *m)
-            {
-                for (const auto &module_instance : t.get_parent().symboltable_instances_)
-                {
-                    auto prefix_str = get_prefix(c, module_instance);
-                    auto member_str = get_memberstr(c, t, prefix_str);
-
-                    auto lhs_str = "faulty_.vrtl_." + member_str;
-                    auto rhs_str = "reference_.vrtl_." + member_str;
-                    auto xor_str = "this->vrtl_." + member_str;
-
-                    x << R"(
-    // )" << prefix_str
-                      << "." << t.get_id() << ":"
-                      << R"(
-    faulty_target2id_[faulty_.get_target)"
-                      << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << td_nmb << R"(;
-    reference_target2id_[reference_.get_target)"
-                      << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << td_nmb << R"(;
-    diff_target2id_[get_target)"
-                      << "(\"" << prefix_str << "." << t.get_id() << "\")] = " << td_nmb << R"(;
-)";
-                    ++td_nmb;
-                }
-            }
-            return true;
-        };
-        core.foreach_injection_target(targetiterf);
-
-        return true;
-    };
-
-    td_nmb = 0;
-    core.foreach_module(writetarget2idinit);
+            x << R"(
+    init_target2id_shard_)"
+              << i << "();";
+        }
+    }
     x << R"(
 }
 )";
 
-    auto writecomparebody = [&](const types::Module &M) -> bool
-    {
-        types::Module const *m = &M;
-        types::Cell const *c = nullptr;
-
-        auto celliter = [&](const types::Cell &C) -> bool
-        {
-            if (m == core.get_module_from_cell(C))
-            {
-                c = &C;
-                return false;
-            }
-            return true;
-        };
-        core.foreach_cell(celliter);
-
-        if (c == nullptr)
-        {
-            LOG_FATAL("Can not find parent Cell of Module ", m->get_id(), " [", m->get_name(), "]");
-        }
-        auto targetiterf = [&](const types::Target &t) -> bool
-        {
-            if (t.get_parent() == *m)
-            {
-                for (const auto &module_instance : t.get_parent().symboltable_instances_)
-                {
-                    auto prefix_str = get_prefix(c, module_instance);
-                    auto member_str = get_memberstr(c, t, prefix_str);
-
-                    auto cxxdim = t.get_cxx_dimension_lengths();
-
-                    auto lhs_str = "faulty_.vrtl_." + member_str;
-                    auto rhs_str = "reference_.vrtl_." + member_str;
-                    auto xor_str = "this->vrtl_." + member_str;
-
-                    if (!fast_compare)
-                    {
-                        x << R"(
-    )";
-                    }
-                    else
-                    {
-                        x << R"(
-        case )" << td_nmb << ": ";
-                    }
-                    x << "// )" << prefix_str << "." << t.get_id() << ":";
-
-                    switch (cxxdim.size())
-                    {
-                    case 0:
-                    {
-                        if (!fast_compare)
-                        {
-                            x << R"(
-    )" << xor_str << " = (" << lhs_str
-                              << " ^ " << rhs_str << ") & 0x" << std::hex << t.get_element_mask({}) << std::dec << ";";
-                            x << R"(
-    ret += )" << xor_str << "? 1 : 0;";
-                        }
-                        else
-                        {
-                            x << R"(
-            if(__UNLIKELY(()" << lhs_str
-                              << " ^ " << rhs_str << ") & 0x" << std::hex << t.get_element_mask({}) << std::dec << "))"
-                              << R"(
-                return faulty_.td_.at)"
-                              << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
-                        }
-                    }
-                    break;
-                    case 1:
-                    {
-                        for (size_t m = 0; m < cxxdim[0]; ++m)
-                        {
-                            if (!fast_compare)
-                            {
-                                x << R"(
-    )" << xor_str << "[" << m << "]"
-                                  << " = (" << lhs_str << "[" << m << "]"
-                                  << " ^ " << rhs_str << "[" << m << "])"
-                                  << " & 0x" << std::hex << t.get_element_mask({ m }) << std::dec << ";";
-                                x << R"(
-                                        ret += )"
-                                  << xor_str << "[" << m << "] ? 1 : 0;";
-                            }
-                            else
-                            {
-                                x << R"(
-            if(__UNLIKELY(()" << lhs_str
-                                  << "[" << m << "]"
-                                  << " ^ " << rhs_str << "[" << m << "]) & 0x" << std::hex << t.get_element_mask({ m })
-                                  << std::dec << "))"
-                                  << R"(
-                return faulty_.td_.at)"
-                                  << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
-                            }
-                        }
-                    }
-                    break;
-                    case 2:
-                    {
-                        for (size_t l = 0; l < cxxdim[1]; ++l)
-                            for (size_t m = 0; m < cxxdim[0]; ++m)
-                            {
-                                if (!fast_compare)
-                                {
-                                    x << R"(
-    )" << xor_str << "[" << m << "]"
-                                      << "[" << l << "]"
-                                      << " = (" << lhs_str << "[" << m << "]"
-                                      << "[" << l << "]"
-                                      << " ^ " << rhs_str << "[" << m << "]"
-                                      << "[" << l << "]) & 0x" << std::hex << t.get_element_mask({ l, m }) << std::dec
-                                      << ";";
-                                    x << R"(
-    ret += )" << xor_str << "[" << m << "]"
-                                      << "[" << l << "] ? 1 : 0;";
-                                }
-                                else
-                                {
-                                    x << R"(
-            if(__UNLIKELY(()" << lhs_str
-                                      << "[" << m << "]"
-                                      << "[" << l << "]"
-                                      << " ^ " << rhs_str << "[" << m << "]"
-                                      << "[" << l << "]) & 0x" << std::hex << t.get_element_mask({ l, m }) << std::dec
-                                      << " ))"
-                                      << R"(
-                return faulty_.td_.at)"
-                                      << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
-                                }
-                            }
-                    }
-                    break;
-                    case 3:
-                    {
-                        for (size_t k = 0; k < cxxdim[2]; ++k)
-                            for (size_t l = 0; l < cxxdim[1]; ++l)
-                                for (size_t m = 0; m < cxxdim[0]; ++m)
-                                {
-                                    if (!fast_compare)
-                                    {
-                                        x << R"(
-    )" << xor_str << "[" << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "]"
-                                          << " = (" << lhs_str << "[" << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "]"
-                                          << " ^ " << rhs_str << "[" << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "]) & 0x" << std::hex << t.get_element_mask({ k, l, m })
-                                          << std::dec << ";";
-                                        x << R"(
-    ret += )" << xor_str << "[" << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "] ? 1 : 0;";
-                                    }
-                                    else
-                                    {
-                                        x << R"(
-            if(__UNLIKELY(()" << lhs_str << "["
-                                          << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "]"
-                                          << " ^ " << rhs_str << "[" << m << "]"
-                                          << "[" << l << "]"
-                                          << "[" << k << "]) & 0x" << std::hex << t.get_element_mask({ k, l, m })
-                                          << std::dec << "))"
-                                          << R"(
-                return faulty_.td_.at)"
-                                          << "(\"" << prefix_str << "." << t.get_id() << "\").get();";
-                                    }
-                                }
-                    }
-                    break;
-                    default:
-                        LOG_ERROR("CType dimensions of injection target not supported: ", t.get_cxx_type());
-                        break;
-                    }
-                    if (fast_compare)
-                    {
-                        x << R"(
-        [[ fallthrough ]];)";
-                    }
-                    x << std::endl;
-                    ++td_nmb;
-                }
-            }
-            return true;
-        };
-        core.foreach_injection_target(targetiterf);
-
-        return true;
-    };
-
     x << R"(
 )"
       << "int " << api_name << "Differential::diff_target_dictionaries(void)"
@@ -483,9 +607,25 @@ std::string VapiGenerator::VapiSource::generate_body(void) const
     int ret = 0;
 )";
 
-    td_nmb = 0;
-    fast_compare = false;
-    core.foreach_module(writecomparebody);
+    if (compare_table)
+    {
+        x << R"(
+    ret += vrtlfi::td::diff_table(compare_table_);)";
+    }
+    else if (shards == 1)
+    {
+        write_chunked(x, entries, 0, entries.size(), jobs, [&](std::ostream &os, size_t begin, size_t end)
+                      { write_compare(os, entries, begin, end, false); });
+    }
+    else
+    {
+        for (unsigned i = 0; i < shards; ++i)
+        {
+            x << R"(
+    ret += diff_target_dictionaries_shard_)"
+              << i << "();";
+        }
+    }
 
     if (core.is_systemc())
     {
@@ -535,7 +675,19 @@ std::string VapiGenerator::VapiSource::generate_body(void) const
       << "vrtlfi::td::TDentry const*" << api_name
       << "Differential::compare_fast(vrtlfi::td::TDentry const *start) const"
       << R"(
-{
+{)";
+
+    if (compare_table)
+    {
+        x << R"(
+    return vrtlfi::td::compare_table(compare_table_, get_id(start));
+}
+
+)";
+    }
+    else if (shards == 1)
+    {
+        x << R"(
     size_t id = get_id(start);
     bool break_ = (id == 0);
 
@@ -543,11 +695,10 @@ compare_rotate_switch_entry:
     switch(id)
     {
 )";
-    td_nmb = 0;
-    fast_compare = true;
-    core.foreach_module(writecomparebody);
+        write_chunked(x, entries, 0, entries.size(), jobs, [&](std::ostream &os, size_t begin, size_t end)
+                      { write_compare(os, entries, begin, end, true); });
 
-    x << R"(
+        x << R"(
         default:
         {
             if (!break_)
@@ -563,6 +714,56 @@ compare_rotate_switch_entry:
 }
 
 )";
+    }
+    else
+    {
+        x << R"(
+    size_t id = get_id(start);
+    bool break_ = (id == 0);
+)";
+        // shard i compares the ids [bounds[i], bounds[i+1]), a mismatch-free shard falls through to the next one
+        x << "    static constexpr size_t shard_bounds[] = { ";
+        for (size_t i = 0; i < bounds.size(); ++i)
+        {
+            x << (i ? ", " : "") << bounds[i];
+        }
+        x << R"( };
+    using compare_shard_t = vrtlfi::td::TDentry const* ()"
+          << api_name << R"(Differential::*)(size_t) const;
+    static constexpr compare_shard_t compare_shards[] = {)";
+        for (unsigned i = 0; i < shards; ++i)
+        {
+            x << R"(
+        &)" << api_name
+              << "Differential::compare_fast_shard_" << i << ",";
+        }
+        x << R"(
+    };
+
+compare_rotate_shard_entry:
+    for (size_t shard = 0; shard < )"
+          << shards << R"(; ++shard)
+    {
+        if (id < shard_bounds[shard + 1])
+        {
+            if (auto ret = (this->*compare_shards[shard])(id))
+            {
+                return ret;
+            }
+            id = shard_bounds[shard + 1];
+        }
+    }
+    if (!break_)
+    {
+        id = 0;
+        break_ = true;
+        goto compare_rotate_shard_entry;
+    }
+    return nullptr;
+}
+
+)";
+    }
 
     x << R"(
 size_t )"
@@ -585,13 +786,28 @@ size_t )"
 
 )";
 
-    x << R"(void )" << api_name << R"(Differential::dump_diff_csv(std::ostream& out) const
+    x << R"(std::vector<vrtlfi::td::TDentry const*> )" << api_name << R"(Differential::get_diff_targets(void) const
 {
+    std::vector<vrtlfi::td::TDentry const*> ret;
+    ret.reserve(diff_target2id_.size());
     for(auto const& it: diff_target2id_)
     {
-        out << (it.first)->get_name() << ", 0b";
+        ret.push_back(it.first);
+    }
+    std::sort(ret.begin(), ret.end(), [](vrtlfi::td::TDentry const *a, vrtlfi::td::TDentry const *b)
+              { return a->get_name() < b->get_name(); });
+    return ret;
+}
 
-        auto bitvector = (it.first)->read_data();
+)";
+
+    x << R"(void )" << api_name << R"(Differential::dump_diff_csv(std::ostream& out) const
+{
+    for(auto const target: get_diff_targets())
+    {
+        out << target->get_name() << ", 0b";
+
+        auto bitvector = target->read_data();
         for (auto it = bitvector.rbegin(); it != bitvector.rend(); ++it)
         {
             out << int(*it);
@@ -647,9 +863,9 @@ size_t )"
     if(header)
     {
         header = false;
-        for(auto it = diff_target2id_.begin(); it != diff_target2id_.end(); ++it)
+        for(auto const target: get_diff_targets())
         {
-            out << (it->first)->get_name() << ",";
+            out << target->get_name() << ",";
         }
 )";
     if (core.is_systemc())
@@ -678,9 +894,9 @@ size_t )"
         out << std::endl;
     }
 
-    for(auto it = diff_target2id_.begin(); it != diff_target2id_.end(); ++it)
+    for(auto const target: get_diff_targets())
     {
-        auto bitvector = (it->first)->read_data();
+        auto bitvector = target->read_data();
         for (auto bit = bitvector.rbegin(); bit != bitvector.rend(); ++bit)
         {
             out << int(*bit);
@@ -728,7 +944,78 @@ size_t )"
     out << std::endl;
 }
 )";
+}
+
+std::string VapiGenerator::VapiSource::generate_body(void) const
+{
+    std::stringstream x;
+    write_body(x);
+    return x.str();
+}
+
+void VapiGenerator::VapiSourceShard::write_body(std::ostream &x) const
+{
+    const auto &core = gen_.get_core();
+    const unsigned jobs = gen_.get_jobs();
+    const auto &entries = gen_.get_entries();
+    const auto &bounds = gen_.get_shard_bounds();
+    const size_t begin = bounds.at(shard_), end = bounds.at(shard_ + 1);
+
+    std::string api_name = get_api_name(core);
+
+    x << get_includes(gen_) << "void " << api_name << "::init_td_shard_" << shard_ << R"((void)
+{
+)";
+    write_chunked(x, entries, begin, end, jobs,
+                  [&](std::ostream &os, size_t begin, size_t end) { write_init_td(os, entries, begin, end); });
+    x << R"(}
+
+void )" << api_name
+      << "Differential::init_target2id_shard_" << shard_ << R"((void)
+{)";
+    write_chunked(x, entries, begin, end, jobs,
+                  [&](std::ostream &os, size_t begin, size_t end) { write_target2id(os, entries, begin, end); });
+    if (gen_.get_compare_table())
+    {
+        write_chunked(x, entries, begin, end, jobs, [&](std::ostream &os, size_t begin, size_t end)
+                      { write_compare_descriptors(os, entries, begin, end); });
+        x << "}\n";
+        return;
+    }
+    x << R"(}
+
+int )" << api_name
+      << "Differential::diff_target_dictionaries_shard_" << shard_ << R"((void)
+{
+    int ret = 0;
+)";
+    write_chunked(x, entries, begin, end, jobs, [&](std::ostream &os, size_t begin, size_t end)
+                  { write_compare(os, entries, begin, end, false); });
+    x << R"(
+    return ret;
+}
+
+vrtlfi::td::TDentry const* )"
+      << api_name << "Differential::compare_fast_shard_" << shard_ << R"((size_t id) const
+{
+    switch(id)
+    {
+)";
+    write_chunked(x, entries, begin, end, jobs, [&](std::ostream &os, size_t begin, size_t end)
+                  { write_compare(os, entries, begin, end, true); });
+    x << R"(
+        default:
+        break;
+    }
+    return nullptr;
+}
+)";
+}
 
+std::string VapiGenerator::VapiSourceShard::generate_body(void) const
+{
+    std::stringstream x;
+    write_body(x);
     return x.str();
 }
 
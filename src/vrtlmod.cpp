@@ -76,11 +76,6 @@ std::unique_ptr<clang::tooling::ToolAction> CreateMacroRewritePass(VrtlmodCore &
     return clang::tooling::newFrontendActionFactory<vrtlmod::transform::rewrite::RewriteMacrosAction>();
 }
 
-std::unique_ptr<clang::tooling::ToolAction> CreateCommentRewritePass(VrtlmodCore &core)
-{
-    return clang::tooling::newFrontendActionFactory<vrtlmod::transform::rewrite::RewriteCommentsAction>();
-}
-
 std::unique_ptr<clang::tooling::ToolAction> CreateElaboratePass(VrtlmodCore &core)
 {
     return newGeneratorFrontendActionFactory<vrtlmod::ParserAction<vrtlmod::passes::ElaboratePass>>(core);
@@ -91,14 +86,35 @@ std::unique_ptr<clang::tooling::ToolAction> CreateAnalyzePass(VrtlmodCore &core)
     return newGeneratorFrontendActionFactory<vrtlmod::ParserAction<vrtlmod::passes::AnalyzePass>>(core);
 }
 
+std::unique_ptr<clang::tooling::ToolAction> CreateElaborateAnalyzePass(VrtlmodCore &core)
+{
+    return newGeneratorFrontendActionFactory<
+        vrtlmod::ParserAction<vrtlmod::passes::ElaboratePass, vrtlmod::passes::AnalyzePass>>(core);
+}
+
 std::unique_ptr<clang::tooling::ToolAction> CreateSignalDeclPass(VrtlmodCore &core)
 {
     return newGeneratorFrontendActionFactory<vrtlmod::ParserAction<vrtlmod::passes::SignalDeclRewriter>>(core);
 }
 
+std::unique_ptr<clang::tooling::ToolAction> CreateBatchSignalDeclPass(VrtlmodCore &core)
+{
+    return newGeneratorFrontendActionFactory<vrtlmod::ParserAction<vrtlmod::passes::BatchSignalDeclRewriter>>(core);
+}
+
 std::unique_ptr<clang::tooling::ToolAction> CreateInjectionPass(VrtlmodCore &core)
 {
     return newGeneratorFrontendActionFactory<vrtlmod::ParserAction<vrtlmod::passes::InjectionRewriter>>(core);
 }
 
+ASTPass CreateElaborateASTPass(VrtlmodCore &core)
+{
+    return [&core](clang::ASTUnit &ast) { vrtlmod::run_passes<vrtlmod::passes::ElaboratePass>(core, ast); };
+}
+
+ASTPass CreateAnalyzeASTPass(VrtlmodCore &core)
+{
+    return [&core](clang::ASTUnit &ast) { vrtlmod::run_passes<vrtlmod::passes::AnalyzePass>(core, ast); };
+}
+
 } // namespace vrtlmod
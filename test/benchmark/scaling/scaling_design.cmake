@@ -0,0 +1,112 @@
+####################################################################################################
+# Copyright 2022 Chair of EDA, Technical University of Munich
+#
+# Licensed under the Apache License, Version 2.0 (the License);
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an AS IS BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+####################################################################################################
+
+######################################################################
+# \file: scaling_design.cmake
+# \brief: Generator of synthetic SystemVerilog designs for the vrtlmod scaling benchmark
+# \details: `scaling_design(FILE <sv> TOP <name> MODULES <N> REGS <M> FANOUT <F>)` writes a design of N module
+#           types with M registers each, instantiated F times each by the top module. The registers cycle through
+#           the Verilator base types, i.e., CData, SData, IData, QData, VlWide, and VlUnpacked arrays of 1 to 3
+#           dimensions with narrow and wide elements. All registers drive the outputs, so none is optimized away.
+#######################################################################
+
+cmake_minimum_required(VERSION 3.15)
+
+# register kinds: <packed range>;<unpacked dimensions>;<unpacked element selects for the output reduction>
+set(SCALING_REG_KINDS
+    "[7:0]||"
+    "[15:0]||"
+    "[31:0]||"
+    "[63:0]||"
+    "[95:0]||"
+    "[64:0]||"
+    "[2:0]|[4]|[0],[1],[2],[3]"
+    "[64:0]|[2]|[0],[1]"
+    "[15:0]|[2][3]|[0][0],[0][1],[0][2],[1][0],[1][1],[1][2]"
+    "[70:0]|[2][2]|[0][0],[0][1],[1][0],[1][1]"
+    "[4:0]|[2][2][2]|[0][0][0],[0][0][1],[0][1][0],[0][1][1],[1][0][0],[1][0][1],[1][1][0],[1][1][1]"
+    "[80:0]|[2][1][2]|[0][0][0],[0][0][1],[1][0][0],[1][0][1]"
+)
+list(LENGTH SCALING_REG_KINDS SCALING_REG_KIND_COUNT)
+
+function(scaling_design)
+    set(oneValueArgs
+        FILE
+        TOP
+        MODULES
+        REGS
+        FANOUT
+    )
+    cmake_parse_arguments(DESIGN "" "${oneValueArgs}" "" ${ARGN})
+
+    set(SV "// generated by scaling_design.cmake: ${DESIGN_MODULES} modules, ${DESIGN_REGS} registers per module, ")
+    string(APPEND SV "fan-out ${DESIGN_FANOUT}\n\n")
+
+    math(EXPR LAST_MODULE "${DESIGN_MODULES} - 1")
+    math(EXPR LAST_REG "${DESIGN_REGS} - 1")
+    foreach(m RANGE ${LAST_MODULE})
+        set(DECLS "")
+        set(RESETS "")
+        set(UPDATES "")
+        set(REDUCTION "1'b0")
+        foreach(r RANGE ${LAST_REG})
+            # offset by module, so that modules differ in their register mix
+            math(EXPR KIND "(${r} + ${m}) % ${SCALING_REG_KIND_COUNT}")
+            list(GET SCALING_REG_KINDS ${KIND} KIND_STR)
+            string(REPLACE "|" ";" KIND_STR "${KIND_STR}")
+            list(GET KIND_STR 0 PACKED)
+            list(GET KIND_STR 1 UNPACKED)
+            list(GET KIND_STR 2 ELEMENTS)
+            set(NAME "r${r}_q")
+            string(APPEND DECLS "  logic${PACKED} ${NAME}${UNPACKED};\n")
+            if(ELEMENTS)
+                string(REPLACE "," ";" ELEMENTS "${ELEMENTS}")
+            else()
+                set(ELEMENTS " ")
+            endif()
+            foreach(e ${ELEMENTS})
+                string(STRIP "${e}" e)
+                string(APPEND RESETS "      ${NAME}${e} <= '0;\n")
+                string(APPEND UPDATES "      ${NAME}${e} <= ${NAME}${e} + {4{d}} + ${r};\n")
+                string(APPEND REDUCTION " ^ (^${NAME}${e})")
+            endforeach()
+        endforeach()
+
+        string(APPEND SV "module scaling_m${m}\n")
+        string(APPEND SV "  (\n    input logic clk, reset,\n    input logic[31:0] d,\n    output logic o\n  );\n")
+        # keep the module hierarchy, i.e., one verilated class per module
+        string(APPEND SV "  /*verilator no_inline_module*/\n${DECLS}\n")
+        string(APPEND SV "  assign o = ${REDUCTION};\n\n")
+        string(APPEND SV "  always_ff @(posedge clk, posedge reset)\n")
+        string(APPEND SV "    if(reset) begin\n${RESETS}    end else begin\n${UPDATES}    end\nendmodule\n\n")
+    endforeach()
+
+    math(EXPR OUTPUTS "${DESIGN_MODULES} * ${DESIGN_FANOUT}")
+    math(EXPR LAST_OUTPUT "${OUTPUTS} - 1")
+    math(EXPR LAST_INSTANCE "${DESIGN_FANOUT} - 1")
+    string(APPEND SV "module ${DESIGN_TOP}\n")
+    string(APPEND SV "  (\n    input logic clk, reset,\n    input logic[31:0] d,\n")
+    string(APPEND SV "    output logic[${LAST_OUTPUT}:0] o\n  );\n")
+    foreach(m RANGE ${LAST_MODULE})
+        foreach(i RANGE ${LAST_INSTANCE})
+            math(EXPR BIT "${m} * ${DESIGN_FANOUT} + ${i}")
+            string(APPEND SV "  scaling_m${m} u_m${m}_${i}(.clk(clk), .reset(reset), .d(d ^ ${BIT}), .o(o[${BIT}]));\n")
+        endforeach()
+    endforeach()
+    string(APPEND SV "endmodule\n")
+
+    file(WRITE ${DESIGN_FILE} "${SV}")
+endfunction()
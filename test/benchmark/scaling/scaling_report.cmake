@@ -0,0 +1,77 @@
+####################################################################################################
+# Copyright 2022 Chair of EDA, Technical University of Munich
+#
+# Licensed under the Apache License, Version 2.0 (the License);
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an AS IS BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+####################################################################################################
+
+######################################################################
+# \file: scaling_report.cmake
+# \brief: Summarizes vrtlmod --time-report JSONs of the scaling benchmark to a CSV
+# \details: `cmake -DREPORTS=<json;...> -DCSV=<csv> -P scaling_report.cmake`. One row per report: design (directory
+#           name), total wall/CPU time and peak RSS, and the wall time of each stage. Stages missing in a report
+#           (e.g., pch without --pch) are left empty.
+#######################################################################
+
+cmake_minimum_required(VERSION 3.19)
+
+# union of stage names, in order of first appearance
+set(STAGES "")
+foreach(REPORT ${REPORTS})
+    file(READ ${REPORT} JSON)
+    string(JSON STAGE_COUNT LENGTH "${JSON}" stages)
+    if(STAGE_COUNT GREATER 0)
+        math(EXPR LAST_STAGE "${STAGE_COUNT} - 1")
+        foreach(i RANGE ${LAST_STAGE})
+            string(JSON NAME GET "${JSON}" stages ${i} name)
+            if(NOT NAME IN_LIST STAGES)
+                list(APPEND STAGES "${NAME}")
+            endif()
+        endforeach()
+    endif()
+endforeach()
+
+set(CSV_STR "design,wall_s,cpu_s,peak_rss_kb")
+foreach(NAME ${STAGES})
+    string(REPLACE " " "_" COLUMN "${NAME}_wall_s")
+    string(APPEND CSV_STR ",${COLUMN}")
+endforeach()
+string(APPEND CSV_STR "\n")
+
+foreach(REPORT ${REPORTS})
+    file(READ ${REPORT} JSON)
+    get_filename_component(DESIGN_DIR ${REPORT} DIRECTORY)
+    get_filename_component(DESIGN ${DESIGN_DIR} NAME)
+    string(JSON WALL GET "${JSON}" total wall_s)
+    string(JSON CPU GET "${JSON}" total cpu_s)
+    string(JSON RSS GET "${JSON}" total peak_rss_kb)
+    string(APPEND CSV_STR "${DESIGN},${WALL},${CPU},${RSS}")
+
+    string(JSON STAGE_COUNT LENGTH "${JSON}" stages)
+    math(EXPR LAST_STAGE "${STAGE_COUNT} - 1")
+    foreach(NAME ${STAGES})
+        set(STAGE_WALL "")
+        if(STAGE_COUNT GREATER 0)
+            foreach(i RANGE ${LAST_STAGE})
+                string(JSON STAGE_NAME GET "${JSON}" stages ${i} name)
+                if(STAGE_NAME STREQUAL NAME)
+                    string(JSON STAGE_WALL GET "${JSON}" stages ${i} wall_s)
+                endif()
+            endforeach()
+        endif()
+        string(APPEND CSV_STR ",${STAGE_WALL}")
+    endforeach()
+    string(APPEND CSV_STR "\n")
+endforeach()
+
+file(WRITE ${CSV} "${CSV_STR}")
+message("${CSV_STR}")